@@ -0,0 +1,153 @@
+//
+// trace_format.h  Binary workload traces for TraceReplay
+//
+// NOTES:
+// A trace is a recorded stream of container operations.  The file is a fixed header followed by
+// fixed-size records, both in native byte order:
+//
+//   TraceHeader   header             magic, version, byte order check and record count
+//   TraceRecord   records[count]     operation, key and value, replayed in file order
+//
+// Insert, Delete and Search address the keyed containers (Linked_List and BSTree); Enqueue and
+// Dequeue address Queue.  A container replays the records it has an operation for and skips the
+// rest, so one trace drives every container.
+//
+
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char TraceMagic[8] = {'C', 'T', 'R', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t TraceVersion = 1;
+static const uint32_t TraceByteOrder = 0x01020304;   // Reads back differently on a foreign-endian machine
+
+// Exception classes
+class TraceFileError: public std::exception { };     // Exception class models an unreadable or unwritable trace file
+class TraceFormatError: public std::exception { };   // Exception class models a malformed trace file
+
+// Operations a trace record can hold
+enum class TraceOp : uint8_t {
+    Insert = 1,                          // Insert key with value
+    Delete = 2,                          // Delete key
+    Search = 3,                          // Look up key
+    Enqueue = 4,                         // Enqueue key
+    Dequeue = 5                          // Dequeue the front value
+};
+
+// Fixed-size header at the start of every trace
+struct TraceHeader {
+    char magic[8];                       // TraceMagic
+    uint32_t version;                    // TraceVersion
+    uint32_t byteOrder;                  // TraceByteOrder as written by the recording machine
+    uint64_t count;                      // Number of records
+};
+
+// One recorded operation
+struct TraceRecord {
+    TraceOp op;
+    uint8_t reserved[3];                 // Zero
+    int32_t key;
+    float value;                         // Data stored by Insert; zero for other operations
+};
+
+static_assert(sizeof(TraceHeader) == 24, "trace header must stay 24 bytes");
+static_assert(sizeof(TraceRecord) == 12, "trace record must stay 12 bytes");
+
+// ReadTrace()
+// Returns every record of the trace at path
+// Throws TraceFileError if the file cannot be read and TraceFormatError if it is not a valid trace
+inline vector<TraceRecord> ReadTrace(const string &path) {
+    FILE *in = fopen(path.c_str(), "rb");
+    if (in == nullptr)
+        throw TraceFileError();
+
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1) {
+        fclose(in);
+        throw TraceFormatError();
+    }
+
+    if (memcmp(header.magic, TraceMagic, sizeof(TraceMagic)) != 0 || header.version != TraceVersion ||
+        header.byteOrder != TraceByteOrder || header.count > SIZE_MAX / sizeof(TraceRecord)) {
+        fclose(in);
+        throw TraceFormatError();
+    }
+
+    vector<TraceRecord> records(static_cast<size_t>(header.count));
+    bool complete = fread(records.data(), sizeof(TraceRecord), records.size(), in) == records.size();
+
+    fclose(in);
+    if (!complete)
+        throw TraceFormatError();
+
+    for (const TraceRecord &record : records) {
+        if (record.op < TraceOp::Insert || record.op > TraceOp::Dequeue)
+            throw TraceFormatError();
+    }
+
+    return records;
+}
+
+// WriteTrace()
+// Writes records to a trace file at path, replacing it only once the whole trace is written
+// Throws TraceFileError if the file cannot be written
+inline void WriteTrace(const string &path, const vector<TraceRecord> &records) {
+    TraceHeader header;
+    memcpy(header.magic, TraceMagic, sizeof(TraceMagic));
+    header.version = TraceVersion;
+    header.byteOrder = TraceByteOrder;
+    header.count = records.size();
+
+    const string tmpPath = path + ".tmp";
+    FILE *out = fopen(tmpPath.c_str(), "wb");
+    if (out == nullptr)
+        throw TraceFileError();
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(records.data(), sizeof(TraceRecord), records.size(), out) == records.size();
+
+    if (fclose(out) != 0 || !ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        throw TraceFileError();
+    }
+}
+
+// GenerateTrace()
+// Returns ops records drawn from seed: 30% Insert, 15% Delete, 35% Search, 10% Enqueue and
+// 10% Dequeue, with keys uniform in [0, keys)
+// Deletes trail inserts, so the keyed containers fill towards keys entries; enqueues and dequeues
+// balance, so the queue stays short
+inline vector<TraceRecord> GenerateTrace(size_t ops, int keys, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> percent(0, 99);
+    uniform_int_distribution<int32_t> key(0, keys - 1);
+    uniform_real_distribution<float> value(0.0f, 100.0f);
+    vector<TraceRecord> records(ops);
+
+    for (TraceRecord &record : records) {
+        int p = percent(rng);
+
+        record = TraceRecord{TraceOp::Search, {0, 0, 0}, key(rng), 0.0f};
+        if (p < 30) {
+            record.op = TraceOp::Insert;
+            record.value = value(rng);
+        } else if (p < 45) {
+            record.op = TraceOp::Delete;
+        } else if (p >= 80) {
+            record.op = p < 90 ? TraceOp::Enqueue : TraceOp::Dequeue;
+        }
+    }
+
+    return records;
+}
+
+#endif
@@ -0,0 +1,417 @@
+//---------------------------------------------------------------
+// File: trace_replay.cpp
+// Purpose: Replays recorded workload traces against Linked_List, Queue
+//          and BSTree<Item>, and compares the results of two runs.
+//          Usage: TraceReplay generate <trace> [ops] [keys] [seed]
+//                 TraceReplay run <results.csv> <trace>...
+//                 TraceReplay compare <baseline.csv> <results.csv> [tolerance%]
+// Programming Language: C++
+
+#include "trace_format.h"
+#include "linked_list.h"
+#include "queue.h"
+#include "item.h"
+#include "bstree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Linked_List and Queue recurse once per node they pass, so replays run on a thread with a
+// large stack; only the pages actually used count towards the reported RSS
+static const size_t ReplayStackBytes = size_t(1) << 30;
+
+// Outcome of replaying one trace against one container
+struct ReplayResult {
+    uint64_t ops;                        // Records the container replayed
+    uint64_t skipped;                    // Records it has no operation for
+    double seconds;                      // Wall time of one replay of the whole trace, with no per-operation timing
+    uint64_t p50, p90, p99, p999, max;   // Latency percentiles of single operations, in ns
+    long baselineRssKB;                  // Resident set size before the container was created
+    long peakRssKB;                      // Peak resident set size of the replay process
+};
+
+// Replays the keyed operations against a Linked_List
+struct ListBackend {
+    Linked_List list;
+
+    bool Apply(const TraceRecord &record) {
+        float data;
+
+        switch (record.op) {
+            case TraceOp::Insert:
+                list.Insert(record.key, record.value);
+                return true;
+            case TraceOp::Delete:
+                list.Delete(record.key);
+                return true;
+            case TraceOp::Search:
+                list.Search(record.key, &data);
+                return true;
+            default:
+                return false;
+        }
+    }
+};
+
+// Replays the queue operations against a Queue; a Dequeue on an empty queue costs its exception
+struct QueueBackend {
+    Queue queue;
+
+    bool Apply(const TraceRecord &record) {
+        switch (record.op) {
+            case TraceOp::Enqueue:
+                queue.Enqueue(record.key);
+                return true;
+            case TraceOp::Dequeue:
+                try {
+                    queue.Dequeue();
+                } catch (QueueEmpty &) {
+                }
+                return true;
+            default:
+                return false;
+        }
+    }
+};
+
+// Replays the keyed operations against a BSTree<Item> with the given balancing policy
+template<typename Balance>
+struct TreeBackend {
+    BSTree<Item, Balance> tree;
+
+    bool Apply(const TraceRecord &record) {
+        switch (record.op) {
+            case TraceOp::Insert:
+                try {
+                    tree.EmplaceItem(record.key, string(), record.value);
+                } catch (FoundInBSTree &) {
+                }
+                return true;
+            case TraceOp::Delete:
+                tree.TryDelete(Item(record.key, string(), 0.0f));
+                return true;
+            case TraceOp::Search:
+                tree.Find(Item(record.key, string(), 0.0f));
+                return true;
+            default:
+                return false;
+        }
+    }
+};
+
+// Current resident set size of this process in KiB
+static long CurrentRssKB() {
+    long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm != nullptr) {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(statm);
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Replays records twice, each time against a fresh Backend: once timed as a whole for the
+// throughput, and once timing every operation the backend accepts for the latency percentiles
+template<typename Backend>
+static ReplayResult Replay(const vector<TraceRecord> &records) {
+    ReplayResult result = {};
+    vector<uint64_t> latencies;
+
+    latencies.reserve(records.size());
+    result.baselineRssKB = CurrentRssKB();
+
+    // A clock read costs about as much as a Queue operation, so none are taken inside this loop
+    {
+        Backend backend;
+        auto start = chrono::steady_clock::now();
+
+        for (const TraceRecord &record : records) {
+            if (backend.Apply(record))
+                result.ops++;
+            else
+                result.skipped++;
+        }
+
+        result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    {
+        Backend backend;
+
+        for (const TraceRecord &record : records) {
+            auto start = chrono::steady_clock::now();
+            bool applied = backend.Apply(record);
+            auto stop = chrono::steady_clock::now();
+
+            if (applied)
+                latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(stop - start).count());
+        }
+    }
+
+    if (!latencies.empty()) {
+        sort(latencies.begin(), latencies.end());
+        auto at = [&latencies](double q) { return latencies[static_cast<size_t>(q * (latencies.size() - 1))]; };
+        result.p50 = at(0.50);
+        result.p90 = at(0.90);
+        result.p99 = at(0.99);
+        result.p999 = at(0.999);
+        result.max = latencies.back();
+    }
+
+    return result;
+}
+
+// Runs replay in a child process, on a thread with a ReplayStackBytes stack, so every replay
+// starts from the same heap and its peak RSS is its own
+// Returns false if the child failed
+static bool RunIsolated(const function<ReplayResult()> &replay, ReplayResult *result) {
+    int fds[2];
+
+    fflush(stdout);
+    if (pipe(fds) != 0)
+        return false;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+
+        pthread_attr_t attr;
+        pthread_t thread;
+        pair<const function<ReplayResult()> *, ReplayResult> job(&replay, ReplayResult());
+        auto body = [](void *arg) -> void * {
+            auto *job = static_cast<pair<const function<ReplayResult()> *, ReplayResult> *>(arg);
+            job->second = (*job->first)();
+            return nullptr;
+        };
+
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, ReplayStackBytes);
+        bool ok = pthread_create(&thread, &attr, body, &job) == 0 && pthread_join(thread, nullptr) == 0;
+        ok = ok && write(fds[1], &job.second, sizeof(job.second)) == sizeof(job.second);
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool ok = read(fds[0], result, sizeof(*result)) == sizeof(*result);
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return false;
+
+    result->peakRssKB = usage.ru_maxrss;
+    return ok;
+}
+
+// Returns the file name of path without its directories
+static string BaseName(const string &path) {
+    size_t slash = path.find_last_of('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+static const char *ResultsHeader =
+    "trace,container,ops,skipped,seconds,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,"
+    "peak_rss_kb,rss_growth_kb";
+
+// generate <trace> [ops] [keys] [seed]
+static int Generate(int argc, char **argv) {
+    if (argc < 3)
+        return 2;
+
+    size_t ops = argc > 3 ? strtoull(argv[3], nullptr, 10) : 200000;
+    int keys = argc > 4 ? atoi(argv[4]) : 4096;
+    uint32_t seed = argc > 5 ? static_cast<uint32_t>(strtoul(argv[5], nullptr, 10)) : 1;
+
+    if (keys < 1) {
+        fprintf(stderr, "keys must be at least 1\n");
+        return 2;
+    }
+
+    WriteTrace(argv[2], GenerateTrace(ops, keys, seed));
+    printf("Wrote %zu operations over %d keys (seed %u) to %s\n", ops, keys, seed, argv[2]);
+    return 0;
+}
+
+// run <results.csv> <trace>...
+static int Run(int argc, char **argv) {
+    if (argc < 4)
+        return 2;
+
+    const pair<const char *, ReplayResult (*)(const vector<TraceRecord> &)> backends[] = {
+        {"Linked_List", Replay<ListBackend>},
+        {"Queue", Replay<QueueBackend>},
+        {"BSTree", Replay<TreeBackend<NoBalance>>},
+        {"BSTree_AVL", Replay<TreeBackend<AVLBalance>>},
+    };
+
+    // Check every trace before the results file is replaced, so a bad trace cannot leave a
+    // header-only file behind; each is read again when its turn comes, so only one is in memory
+    for (int i = 3; i < argc; i++)
+        ReadTrace(argv[i]);
+
+    ofstream csv(argv[2]);
+    if (!csv) {
+        fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+    csv << ResultsHeader << "\n" << fixed << setprecision(6);
+
+    printf("%-16s %-12s %10s %12s %8s %8s %8s %8s %10s %10s\n", "trace", "container", "ops", "ops/sec",
+           "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "peak KiB", "growth KiB");
+
+    int failures = 0;
+    for (int i = 3; i < argc; i++) {
+        vector<TraceRecord> records = ReadTrace(argv[i]);
+        string trace = BaseName(argv[i]);
+
+        for (const auto &backend : backends) {
+            ReplayResult r;
+            auto replay = [&backend, &records]() { return backend.second(records); };
+
+            if (!RunIsolated(replay, &r)) {
+                fprintf(stderr, "%s: replay against %s failed\n", trace.c_str(), backend.first);
+                failures++;
+                continue;
+            }
+
+            double opsPerSec = r.seconds > 0 ? r.ops / r.seconds : 0.0;
+            long growth = r.peakRssKB - r.baselineRssKB;
+
+            printf("%-16s %-12s %10llu %12.0f %8llu %8llu %8llu %8llu %10ld %10ld\n", trace.c_str(), backend.first,
+                   (unsigned long long)r.ops, opsPerSec, (unsigned long long)r.p50, (unsigned long long)r.p90,
+                   (unsigned long long)r.p99, (unsigned long long)r.p999, r.peakRssKB, growth);
+            csv << trace << ',' << backend.first << ',' << r.ops << ',' << r.skipped << ',' << r.seconds << ','
+                << opsPerSec << ',' << r.p50 << ',' << r.p90 << ',' << r.p99 << ',' << r.p999 << ','
+                << r.max << ',' << r.peakRssKB << ',' << growth << "\n";
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+// Reads a results file into rows keyed by (trace, container), each row a map of column to value
+static map<pair<string, string>, map<string, double>> ReadResults(const char *path) {
+    map<pair<string, string>, map<string, double>> rows;
+    ifstream in(path);
+    string line;
+    vector<string> columns;
+
+    if (!in || !getline(in, line))
+        throw TraceFileError();
+
+    stringstream header(line);
+    for (string column; getline(header, column, ',');)
+        columns.push_back(column);
+
+    while (getline(in, line)) {
+        stringstream fields(line);
+        vector<string> values;
+
+        for (string value; getline(fields, value, ',');)
+            values.push_back(value);
+        if (values.size() != columns.size() || values.size() < 2)
+            throw TraceFormatError();
+
+        map<string, double> &row = rows[make_pair(values[0], values[1])];
+        for (size_t i = 2; i < values.size(); i++)
+            row[columns[i]] = atof(values[i].c_str());
+    }
+
+    return rows;
+}
+
+// compare <baseline.csv> <results.csv> [tolerance%]
+// Exits with 1 if any throughput fell, or any p99 latency rose, by more than tolerance
+static int Compare(int argc, char **argv) {
+    if (argc < 4)
+        return 2;
+
+    double tolerance = (argc > 4 ? atof(argv[4]) : 10.0) / 100.0;
+    auto baseline = ReadResults(argv[2]);
+    auto current = ReadResults(argv[3]);
+    int regressions = 0;
+
+    printf("%-16s %-12s %14s %14s %8s %10s %10s %8s\n", "trace", "container", "base ops/sec", "ops/sec",
+           "change", "base p99", "p99", "change");
+
+    for (const auto &entry : current) {
+        auto old = baseline.find(entry.first);
+        if (old == baseline.end()) {
+            printf("%-16s %-12s (not in baseline)\n", entry.first.first.c_str(), entry.first.second.c_str());
+            continue;
+        }
+
+        const map<string, double> &now = entry.second;
+        const map<string, double> &then = old->second;
+        double throughput = then.at("ops_per_sec") > 0 ? now.at("ops_per_sec") / then.at("ops_per_sec") - 1 : 0;
+        double p99 = then.at("p99_ns") > 0 ? now.at("p99_ns") / then.at("p99_ns") - 1 : 0;
+        bool regressed = throughput < -tolerance || p99 > tolerance;
+
+        printf("%-16s %-12s %14.0f %14.0f %+7.1f%% %10.0f %10.0f %+7.1f%%%s\n", entry.first.first.c_str(),
+               entry.first.second.c_str(), then.at("ops_per_sec"), now.at("ops_per_sec"), 100 * throughput,
+               then.at("p99_ns"), now.at("p99_ns"), 100 * p99, regressed ? "  REGRESSION" : "");
+        regressions += regressed;
+    }
+
+    for (const auto &entry : baseline) {
+        if (current.find(entry.first) == current.end())
+            printf("%-16s %-12s (missing from results)\n", entry.first.first.c_str(), entry.first.second.c_str());
+    }
+
+    printf("\n%d regression(s) beyond %.1f%%\n", regressions, 100 * tolerance);
+    return regressions == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    string command = argc > 1 ? argv[1] : "";
+    int status = 2;
+
+    try {
+        if (command == "generate")
+            status = Generate(argc, argv);
+        else if (command == "run")
+            status = Run(argc, argv);
+        else if (command == "compare")
+            status = Compare(argc, argv);
+    } catch (TraceFileError &) {
+        fprintf(stderr, "Cannot read or write a trace or results file\n");
+        return 1;
+    } catch (TraceFormatError &) {
+        fprintf(stderr, "Malformed trace or results file\n");
+        return 1;
+    } catch (out_of_range &) {
+        fprintf(stderr, "Results file is missing a column\n");
+        return 1;
+    }
+
+    if (status == 2) {
+        fprintf(stderr, "Usage: TraceReplay generate <trace> [ops] [keys] [seed]\n"
+                        "       TraceReplay run <results.csv> <trace>...\n"
+                        "       TraceReplay compare <baseline.csv> <results.csv> [tolerance%%]\n");
+    }
+
+    return status;
+}
@@ -0,0 +1,316 @@
+//
+// instrumentation.h  Opt-in counters for the container classes
+//
+// NOTES:
+// Compiling with CONTAINER_INSTRUMENTATION defined makes Linked_List, Queue and BSTree count,
+// per container kind, the operations they run, the nodes they allocate and free (and the bytes
+// those nodes occupy), the nodes each operation visits and the exceptions they raise.  Without
+// the define every INSTRUMENT_* macro expands to nothing, so the containers compile to the same
+// code as before; the reporting functions still exist and report zeros.
+//
+// Each thread counts into a slot of its own, so counting never contends on a shared cache line.
+// A slot is only written by the thread that owns it (a plain load and store, no locked
+// instruction); Snapshot() sums every slot on demand.  Slots outlive their threads and are reused
+// by new ones, so counts from threads that have exited are kept.
+//
+// "Visits" counts the nodes an operation examines.  The recursive list and queue operations
+// recurse once per node visited, so the largest number of visits by a single operation is also
+// their deepest recursion; for BSTree it is the longest root-to-node descent.  Batched lookups
+// (INSTRUMENT_BATCH) count one operation per key but are left out of that maximum.
+//
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+// Kinds of container that report counters
+enum class InstrumentedContainer { LinkedList, Queue, BSTree };
+
+// Counters merged over every thread for one kind of container
+struct ContainerCounters {
+    uint64_t operations;                 // Public operations started
+    uint64_t allocations;                // Nodes allocated
+    uint64_t frees;                      // Nodes freed
+    uint64_t bytesAllocated;             // Bytes of all nodes allocated
+    uint64_t bytesFreed;                 // Bytes of all nodes freed
+    uint64_t nodesVisited;               // Nodes examined by all operations
+    uint64_t maxVisits;                  // Most nodes examined by a single operation
+    uint64_t exceptions;                 // Exceptions constructed to be thrown
+};
+
+class Instrumentation {                // Per-thread counter slots and their merged reports
+public:
+    static constexpr int ContainerCount = 3;
+
+    enum Field { Operations, Allocations, Frees, BytesAllocated, BytesFreed, NodesVisited, MaxVisits,
+                 Exceptions, FieldCount };
+
+private:
+    // Cache-line aligned (C++17 new honours it), so two threads' slots never share a line
+    struct alignas(64) Slot {            // One thread's counters, reused after the thread exits
+        atomic<uint64_t> values[ContainerCount][FieldCount];
+        atomic<bool> inUse;
+    };
+
+    static_assert(sizeof(Slot) % 64 == 0, "a slot must fill whole cache lines");
+
+    struct Registry {
+        mutex lock;                      // Guards slots
+        vector<Slot *> slots;
+    };
+
+    struct SlotOwner {                   // Returns the thread's slot to the pool when the thread exits
+        Slot *slot = nullptr;
+        ~SlotOwner() {
+            if (slot != nullptr)
+                slot->inUse.store(false, memory_order_release);
+        }
+    };
+
+    // GetRegistry()
+    // The registry is never destroyed, since pool threads may still exit during static destruction
+    static Registry &GetRegistry() {
+        static Registry *registry = new Registry;
+        return *registry;
+    }
+
+    static atomic<uint64_t> &Counter(InstrumentedContainer container, Field field) {
+        return LocalSlot()->values[static_cast<int>(container)][field];
+    }
+
+    static Slot *LocalSlot();
+
+public:
+    static bool Enabled();
+    static void Add(InstrumentedContainer container, Field field, uint64_t n);
+    static void Max(InstrumentedContainer container, Field field, uint64_t n);
+    static uint64_t Local(InstrumentedContainer container, Field field);
+    static ContainerCounters Snapshot(InstrumentedContainer container);
+    static void Reset();
+    static const char *Name(InstrumentedContainer container);
+    static void WriteJSON(ostream &out);
+    static void WriteCSV(ostream &out);
+};
+
+// Counts one operation for its lifetime and records how many nodes it visited
+class InstrumentedOperation {
+private:
+    InstrumentedContainer container;
+    uint64_t startVisits;                // This thread's visit count when the operation began
+
+public:
+    explicit InstrumentedOperation(InstrumentedContainer container) : container(container) {
+        Instrumentation::Add(container, Instrumentation::Operations, 1);
+        this->startVisits = Instrumentation::Local(container, Instrumentation::NodesVisited);
+    }
+
+    ~InstrumentedOperation() {
+        Instrumentation::Max(this->container, Instrumentation::MaxVisits,
+                             Instrumentation::Local(this->container, Instrumentation::NodesVisited) - this->startVisits);
+    }
+
+    InstrumentedOperation(const InstrumentedOperation &) = delete;
+    InstrumentedOperation &operator=(const InstrumentedOperation &) = delete;
+};
+
+#ifdef CONTAINER_INSTRUMENTATION
+#define INSTRUMENT_OPERATION(container) \
+    InstrumentedOperation instrumentedOperation(InstrumentedContainer::container)
+#define INSTRUMENT_BATCH(container, operations) \
+    Instrumentation::Add(InstrumentedContainer::container, Instrumentation::Operations, (operations))
+#define INSTRUMENT_VISIT(container) \
+    Instrumentation::Add(InstrumentedContainer::container, Instrumentation::NodesVisited, 1)
+#define INSTRUMENT_ALLOC(container, nodes, bytes) \
+    (Instrumentation::Add(InstrumentedContainer::container, Instrumentation::Allocations, (nodes)), \
+     Instrumentation::Add(InstrumentedContainer::container, Instrumentation::BytesAllocated, (bytes)))
+#define INSTRUMENT_FREE(container, nodes, bytes) \
+    (Instrumentation::Add(InstrumentedContainer::container, Instrumentation::Frees, (nodes)), \
+     Instrumentation::Add(InstrumentedContainer::container, Instrumentation::BytesFreed, (bytes)))
+#else
+#define INSTRUMENT_OPERATION(container) ((void)0)
+#define INSTRUMENT_BATCH(container, operations) ((void)0)
+#define INSTRUMENT_VISIT(container) ((void)0)
+#define INSTRUMENT_ALLOC(container, nodes, bytes) ((void)0)
+#define INSTRUMENT_FREE(container, nodes, bytes) ((void)0)
+#endif
+
+// Base of a container's exception classes; counts every exception of that container that is raised
+template<InstrumentedContainer Container>
+class InstrumentedException: public std::exception {
+public:
+    InstrumentedException() {
+#ifdef CONTAINER_INSTRUMENTATION
+        Instrumentation::Add(Container, Instrumentation::Exceptions, 1);
+#endif
+    }
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// LocalSlot()
+// Returns this thread's counter slot, claiming a free one (or adding one) on first use
+inline Instrumentation::Slot *Instrumentation::LocalSlot() {
+    thread_local SlotOwner owner;
+
+    if (owner.slot == nullptr) {
+        Registry &registry = GetRegistry();
+        lock_guard<mutex> guard(registry.lock);
+
+        for (Slot *slot : registry.slots) {
+            bool expected = false;
+            if (slot->inUse.compare_exchange_strong(expected, true)) {
+                owner.slot = slot;
+                break;
+            }
+        }
+        if (owner.slot == nullptr) {
+            owner.slot = new Slot();
+            owner.slot->inUse.store(true);
+            registry.slots.push_back(owner.slot);
+        }
+    }
+
+    return owner.slot;
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// Enabled()
+// Returns true if the containers were compiled with CONTAINER_INSTRUMENTATION
+inline bool Instrumentation::Enabled() {
+#ifdef CONTAINER_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Add()
+// Adds n to one of the calling thread's counters
+inline void Instrumentation::Add(InstrumentedContainer container, Field field, uint64_t n) {
+    atomic<uint64_t> &counter = Counter(container, field);
+
+    // Only the owning thread writes its slot, so a load and a store are enough
+    counter.store(counter.load(memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Max()
+// Raises one of the calling thread's counters to n if it is below n
+inline void Instrumentation::Max(InstrumentedContainer container, Field field, uint64_t n) {
+    atomic<uint64_t> &counter = Counter(container, field);
+
+    if (counter.load(memory_order_relaxed) < n)
+        counter.store(n, memory_order_relaxed);
+}
+
+// Local()
+// Returns the calling thread's value of one counter
+inline uint64_t Instrumentation::Local(InstrumentedContainer container, Field field) {
+    return Counter(container, field).load(memory_order_relaxed);
+}
+
+// Snapshot()
+// Returns the counters of container merged over every thread that has counted
+// Counts of operations still running on other threads may be partly included
+inline ContainerCounters Instrumentation::Snapshot(InstrumentedContainer container) {
+    Registry &registry = GetRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    uint64_t total[FieldCount] = {};
+
+    for (Slot *slot : registry.slots) {
+        for (int field = 0; field < FieldCount; field++) {
+            uint64_t value = slot->values[static_cast<int>(container)][field].load(memory_order_relaxed);
+
+            if (field == MaxVisits)
+                total[field] = value > total[field] ? value : total[field];
+            else
+                total[field] += value;
+        }
+    }
+
+    return {total[Operations], total[Allocations], total[Frees], total[BytesAllocated],
+            total[BytesFreed], total[NodesVisited], total[MaxVisits], total[Exceptions]};
+}
+
+// Reset()
+// Sets every counter of every thread back to zero
+// Call it only while no container operations are running
+inline void Instrumentation::Reset() {
+    Registry &registry = GetRegistry();
+    lock_guard<mutex> guard(registry.lock);
+
+    for (Slot *slot : registry.slots) {
+        for (auto &fields : slot->values) {
+            for (atomic<uint64_t> &value : fields)
+                value.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+// Name()
+// Returns the class name reported for container
+inline const char *Instrumentation::Name(InstrumentedContainer container) {
+    switch (container) {
+        case InstrumentedContainer::LinkedList:
+            return "Linked_List";
+        case InstrumentedContainer::Queue:
+            return "Queue";
+        default:
+            return "BSTree";
+    }
+}
+
+// WriteJSON()
+// Writes the merged counters of every container to out as one JSON object
+inline void Instrumentation::WriteJSON(ostream &out) {
+    out << "{\"enabled\": " << (Enabled() ? "true" : "false") << ", \"containers\": [";
+
+    for (int i = 0; i < ContainerCount; i++) {
+        InstrumentedContainer container = static_cast<InstrumentedContainer>(i);
+        ContainerCounters c = Snapshot(container);
+
+        out << (i == 0 ? "" : ",") << "\n  {\"container\": \"" << Name(container) << "\""
+            << ", \"operations\": " << c.operations
+            << ", \"allocations\": " << c.allocations
+            << ", \"frees\": " << c.frees
+            << ", \"bytes_live\": " << static_cast<int64_t>(c.bytesAllocated - c.bytesFreed)
+            << ", \"nodes_visited\": " << c.nodesVisited
+            << ", \"visits_per_operation\": " << (c.operations == 0 ? 0.0 : double(c.nodesVisited) / c.operations)
+            << ", \"max_visits\": " << c.maxVisits
+            << ", \"exceptions\": " << c.exceptions << "}";
+    }
+
+    out << "\n]}\n";
+}
+
+// WriteCSV()
+// Writes the merged counters to out as CSV, a header line and then one line per container
+inline void Instrumentation::WriteCSV(ostream &out) {
+    out << "container,operations,allocations,frees,bytes_live,nodes_visited,visits_per_operation,"
+           "max_visits,exceptions\n";
+
+    for (int i = 0; i < ContainerCount; i++) {
+        InstrumentedContainer container = static_cast<InstrumentedContainer>(i);
+        ContainerCounters c = Snapshot(container);
+
+        out << Name(container) << ',' << c.operations << ',' << c.allocations << ',' << c.frees << ','
+            << static_cast<int64_t>(c.bytesAllocated - c.bytesFreed) << ',' << c.nodesVisited << ','
+            << (c.operations == 0 ? 0.0 : double(c.nodesVisited) / c.operations) << ','
+            << c.maxVisits << ',' << c.exceptions << '\n';
+    }
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <list>
 #include <functional>
+#include "../../Common/instrumentation.h"
 
 using namespace std;
 
@@ -20,6 +21,8 @@ class Linked_List {
      private:
           ListItem *head;               // Pointer to the start of the list
 
+          static ListItem *MergeRuns(ListItem *first, ListItem *second);  // Merge two sorted chains
+
      public:
           Linked_List();
           ~Linked_List();
@@ -31,6 +34,11 @@ class Linked_List {
           bool isEmpty();                      // Return true if list is empty
           bool isFull();                       // Return true if list is full
           void PrintList();                    // Print all items in the list
+          void PushFront(int key, float f);    // Add an item to the front without a duplicate check
+          const ListItem *First();             // Return the first item, to walk the list through next
+          bool isSorted();                     // Return true if keys are in ascending order
+          void Sort();                         // Stable in-place sort by key
+          bool MergeSorted(Linked_List &other); // Move all items of a sorted list into this sorted list
 };
 
 Linked_List::Linked_List() {
@@ -42,37 +50,37 @@ Linked_List::~Linked_List() {
 }
 
 void Linked_List::ClearList() {
-    if (this->isEmpty()){
-        return;
-    }
-
-    ListItem *next = head->next;
-    delete [] head;
+    INSTRUMENT_OPERATION(LinkedList);
 
-    while (next->next) {
+    while (head) {
+        ListItem *next = head->next;
+        INSTRUMENT_VISIT(LinkedList);
+        delete head;
+        INSTRUMENT_FREE(LinkedList, 1, sizeof(ListItem));
         head = next;
-        next = head->next;
-        delete [] head;
     }
-
-    head = nullptr;
 }
 
 bool Linked_List::Insert(int key, float f) {
+    INSTRUMENT_OPERATION(LinkedList);
+
     // Set head to new item if list is empty
     if (this->isEmpty()) {
         head = new ListItem;
+        INSTRUMENT_ALLOC(LinkedList, 1, sizeof(ListItem));
         *head = {key, f, nullptr};
         return true;
     }
 
     std::function<bool(ListItem*, int, float)> InsertRecursion = [&InsertRecursion] (ListItem *item, int key, float f) -> bool {
-        if(!item->next){
+        INSTRUMENT_VISIT(LinkedList);
+        if (item->key == key) {
+            return false;   // Key already exists
+        } else if(!item->next){
             item->next = new ListItem;
+            INSTRUMENT_ALLOC(LinkedList, 1, sizeof(ListItem));
             *item->next = {key, f, nullptr};
             return true;
-        } else if (item->key == key) {
-            return false;   // Key already exists
         } else {
             return InsertRecursion(item->next, key, f);
         }
@@ -82,15 +90,22 @@ bool Linked_List::Insert(int key, float f) {
 }
 
 bool Linked_List::Delete(int keyToDelete) {
+    INSTRUMENT_OPERATION(LinkedList);
+
     // Special cases (List is empty or deleting head)
     if (this->isEmpty()) {
         return false;
     } else if (head->key == keyToDelete) {
+        ListItem *oldHead = head;
+        INSTRUMENT_VISIT(LinkedList);
         head = head->next;
+        delete oldHead;
+        INSTRUMENT_FREE(LinkedList, 1, sizeof(ListItem));
         return true;
     }
 
     std::function<bool(ListItem*, int)> InsertRecursion = [&InsertRecursion] (ListItem *item, int keyToDelete) -> bool {
+        INSTRUMENT_VISIT(LinkedList);
         if(!item->next){
             return false;
         } else if (item->next->key == keyToDelete) {
@@ -102,6 +117,8 @@ bool Linked_List::Delete(int keyToDelete) {
                 newNext = nullptr;
             }
 
+            delete item->next;
+            INSTRUMENT_FREE(LinkedList, 1, sizeof(ListItem));
             item->next = newNext;
 
             return true;
@@ -114,10 +131,15 @@ bool Linked_List::Delete(int keyToDelete) {
 }
 
 bool Linked_List::Search(int key, float *retVal) {
+    INSTRUMENT_OPERATION(LinkedList);
+
     std::function<bool (ListItem*, int)> SearchRecursion = [&SearchRecursion, retVal] (ListItem *item, int key) -> bool {
         if(!item){
             return false;
-        } else if (item->key == key) {
+        }
+
+        INSTRUMENT_VISIT(LinkedList);
+        if (item->key == key) {
             *retVal = item->theData;
             return true;
         } else {
@@ -129,13 +151,17 @@ bool Linked_List::Search(int key, float *retVal) {
 }
 
 int Linked_List::ListLength() {
+    INSTRUMENT_OPERATION(LinkedList);
+
     if (this->isEmpty())
         return 0;
 
     ListItem *tmpItem = head;
     int count = 1;
 
+    INSTRUMENT_VISIT(LinkedList);
     while (tmpItem->next){
+        INSTRUMENT_VISIT(LinkedList);
         count++;
         tmpItem = tmpItem->next;
     }
@@ -159,6 +185,8 @@ bool Linked_List::isFull() {
 }
 
 void Linked_List::PrintList() {
+    INSTRUMENT_OPERATION(LinkedList);
+
     if (this->isEmpty()) {
         printf("{}\n");
         return;
@@ -168,6 +196,8 @@ void Linked_List::PrintList() {
         if(!item){
             return "";
         } else {
+            INSTRUMENT_VISIT(LinkedList);
+
             // TODO: find a better way to string format, maybe put listString in lambda globals and append to that
             string listString = "[";
             listString.append(std::to_string(item->key));
@@ -186,4 +216,108 @@ void Linked_List::PrintList() {
 
 }
 
+// Merges the sorted chains first and second into one sorted chain and returns its head
+// Items with equal keys keep their order, those from first coming before those from second
+ListItem *Linked_List::MergeRuns(ListItem *first, ListItem *second) {
+    ListItem *merged = nullptr;
+    ListItem **tail = &merged;
+
+    while (first && second) {
+        INSTRUMENT_VISIT(LinkedList);
+        if (second->key < first->key) {
+            *tail = second;
+            second = second->next;
+        } else {
+            *tail = first;
+            first = first->next;
+        }
+        tail = &(*tail)->next;
+    }
+
+    *tail = first ? first : second;
+    return merged;
+}
+
+// Bulk loading: the caller guarantees key is not already in the list
+void Linked_List::PushFront(int key, float f) {
+    INSTRUMENT_OPERATION(LinkedList);
+
+    ListItem *item = new ListItem;
+    INSTRUMENT_ALLOC(LinkedList, 1, sizeof(ListItem));
+    *item = {key, f, head};
+    head = item;
+}
+
+const ListItem *Linked_List::First() {
+    return head;
+}
+
+bool Linked_List::isSorted() {
+    INSTRUMENT_OPERATION(LinkedList);
+
+    for (ListItem *item = head; item && item->next; item = item->next) {
+        INSTRUMENT_VISIT(LinkedList);
+        if (item->next->key < item->key)
+            return false;
+    }
+
+    return true;
+}
+
+// Bottom-up merge sort that relinks the existing items and allocates nothing
+// runs[i] holds a sorted run of 2^i items taken from earlier in the list than every run below it,
+// so merging runs[i] before the newer run keeps equal keys in their original order
+void Linked_List::Sort() {
+    INSTRUMENT_OPERATION(LinkedList);
+
+    ListItem *runs[64] = {};
+    int used = 0;
+
+    while (head) {
+        ListItem *run = head;
+        head = head->next;
+        run->next = nullptr;
+
+        int i = 0;
+        for (; runs[i]; i++) {
+            run = MergeRuns(runs[i], run);
+            runs[i] = nullptr;
+        }
+        runs[i] = run;
+        used = i + 1 > used ? i + 1 : used;
+    }
+
+    for (int i = 0; i < used; i++) {
+        if (runs[i])
+            head = head ? MergeRuns(runs[i], head) : runs[i];
+    }
+}
+
+// Splices the items of other into this list in linear time and leaves other empty
+// Both lists must be sorted with no key repeated, within either list or between them;
+// otherwise returns false and leaves both lists unchanged
+bool Linked_List::MergeSorted(Linked_List &other) {
+    INSTRUMENT_OPERATION(LinkedList);
+
+    if (&other == this)
+        return this->isEmpty();
+
+    // Walk both lists in merged order once, checking each for ascending keys and the two for a
+    // shared key, before relinking anything
+    for (ListItem *a = head, *b = other.head; a || b; ) {
+        INSTRUMENT_VISIT(LinkedList);
+        if (a && b && a->key == b->key)
+            return false;
+
+        ListItem *&item = (!b || (a && a->key < b->key)) ? a : b;
+        if (item->next && item->next->key <= item->key)
+            return false;
+        item = item->next;
+    }
+
+    head = MergeRuns(head, other.head);
+    other.head = nullptr;
+    return true;
+}
+
 #endif
\ No newline at end of file
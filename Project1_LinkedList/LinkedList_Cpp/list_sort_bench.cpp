@@ -0,0 +1,118 @@
+//---------------------------------------------------------------
+// File: list_sort_bench.cpp
+// Purpose: Benchmarks Linked_List::Sort and MergeSorted against copying
+//          the list into a vector to sort it, and against std::list::sort.
+//          Usage: LinkedList_Sort_Bench [nodeCount]   (default 10000000)
+// Programming Language: C++
+
+#include "linked_list.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Seconds elapsed since start
+static double SecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Returns the keys 0..n-1 in random order
+static vector<int> MakeKeys(int n) {
+    mt19937 rng(42);
+    vector<int> keys(n);
+
+    for (int i = 0; i < n; ++i)
+        keys[i] = i;
+    shuffle(keys.begin(), keys.end(), rng);
+
+    return keys;
+}
+
+// Fills list with keys in the order given
+static void Load(Linked_List &list, const vector<int> &keys) {
+    for (size_t i = keys.size(); i-- > 0; )
+        list.PushFront(keys[i], static_cast<float>(i));
+}
+
+// Times Linked_List::Sort, which relinks the existing nodes
+static void BenchSort(const vector<int> &keys) {
+    Linked_List list;
+    Load(list, keys);
+
+    auto start = chrono::steady_clock::now();
+    list.Sort();
+    double secs = SecondsSince(start);
+
+    printf("%-24s n=%-9zu %8.3f s   sorted %s\n", "Linked_List::Sort", keys.size(), secs,
+           list.isSorted() ? "yes" : "NO");
+}
+
+// Times copying the list into a vector, sorting that, and rebuilding the list from it
+static void BenchCopySortRebuild(const vector<int> &keys) {
+    Linked_List list;
+    Load(list, keys);
+
+    auto start = chrono::steady_clock::now();
+    vector<pair<int, float>> copy;
+    for (const ListItem *item = list.First(); item; item = item->next)
+        copy.emplace_back(item->key, item->theData);
+    stable_sort(copy.begin(), copy.end(),
+                [](const pair<int, float> &a, const pair<int, float> &b) { return a.first < b.first; });
+    list.ClearList();
+    for (size_t i = copy.size(); i-- > 0; )
+        list.PushFront(copy[i].first, copy[i].second);
+    double secs = SecondsSince(start);
+
+    printf("%-24s n=%-9zu %8.3f s   sorted %s\n", "copy-sort-rebuild", keys.size(), secs,
+           list.isSorted() ? "yes" : "NO");
+}
+
+// Times std::list::sort on the same keys
+static void BenchStdList(const vector<int> &keys) {
+    list<pair<int, float>> stdList;
+    for (size_t i = 0; i < keys.size(); ++i)
+        stdList.emplace_back(keys[i], static_cast<float>(i));
+
+    auto start = chrono::steady_clock::now();
+    stdList.sort([](const pair<int, float> &a, const pair<int, float> &b) { return a.first < b.first; });
+    double secs = SecondsSince(start);
+
+    bool sorted = is_sorted(stdList.begin(), stdList.end(),
+                            [](const pair<int, float> &a, const pair<int, float> &b) { return a.first < b.first; });
+    printf("%-24s n=%-9zu %8.3f s   sorted %s\n", "std::list::sort", keys.size(), secs, sorted ? "yes" : "NO");
+}
+
+// Times MergeSorted on two sorted lists holding the even and the odd keys
+static void BenchMergeSorted(int n) {
+    Linked_List evens, odds;
+
+    for (int key = (n - 1) & ~1; key >= 0; key -= 2)
+        evens.PushFront(key, 0.0f);
+    for (int key = (n - 1) | 1; key >= 1; key -= 2) {
+        if (key < n)
+            odds.PushFront(key, 0.0f);
+    }
+
+    auto start = chrono::steady_clock::now();
+    bool merged = evens.MergeSorted(odds);
+    double secs = SecondsSince(start);
+
+    printf("%-24s n=%-9d %8.3f s   merged %s, sorted %s\n", "Linked_List::MergeSorted", n, secs,
+           merged ? "yes" : "NO", evens.isSorted() ? "yes" : "NO");
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+    vector<int> keys = MakeKeys(n);
+
+    BenchSort(keys);
+    BenchCopySortRebuild(keys);
+    BenchStdList(keys);
+    BenchMergeSorted(n);
+
+    return 0;
+}
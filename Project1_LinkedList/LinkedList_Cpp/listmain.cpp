@@ -66,5 +66,14 @@ int main(int argc, char **argv) {
 
     printf("\n\nEnd list demonstration...");
 
+    // Summarize what the list operations above cost
+    if (Instrumentation::Enabled()) {
+        printf("\n\nInstrumentation summary:\n");
+        fflush(stdout);
+        Instrumentation::WriteCSV(cout);
+    } else {
+        printf("\n\n(Configure with -DCONTAINER_INSTRUMENTATION=ON for an instrumentation summary)\n");
+    }
+
     return 0;
 }
\ No newline at end of file
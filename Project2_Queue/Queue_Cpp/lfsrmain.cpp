@@ -0,0 +1,67 @@
+//Main file used to test the queue and the LFSR
+//---------------------------------------------------------------
+// File: lfsrmain.cpp
+// Purpose: Main file with a demonstration of a queue implemented as a
+//          linked structure, and of the LFSR pseudo-random generator
+//          that uses it as a shift register.
+// Programming Language: C++
+
+#include "lfsr.h"
+#include <cstdio>
+
+int main() {
+    Queue q;
+
+    printf("Simple Queue Demonstration\n\n");
+
+    // Enqueue 5 values
+    for (int i = 1; i <= 5; i++)
+        q.Enqueue(10 * i);
+    q.PrintQ();
+    printf("Front = %i, Rear = %i, Peek(2) = %i, Size = %i\n\n", q.Front(), q.Rear(), q.Peek(2), q.Size());
+
+    // Test dequeue
+    printf("Testing dequeue of the front value (10).\n");
+    q.Dequeue();
+    q.PrintQ();
+
+    // Test exceptions with known failure arguments
+    printf("Testing failure in peek (position 9).\n");
+    try {
+        q.Peek(9);
+        printf("FAIL. Should not have been able to peek.\n");
+    } catch (QueueInvalidPeek &e) {
+        printf("PASS. %s\n", e.what());
+    }
+
+    printf("Testing failure in dequeue of an empty queue.\n");
+    q.MakeEmpty();
+    try {
+        q.Dequeue();
+        printf("FAIL. Should not have been able to dequeue.\n");
+    } catch (QueueEmpty &e) {
+        printf("PASS. %s\n", e.what());
+    }
+
+    // Step an LFSR through a few states
+    printf("\nLFSR with seed 01101000010, taps 8 and 10:\n");
+    LFSR lfsr("01101000010", 8, 10);
+    for (int i = 0; i < 10; i++) {
+        lfsr.Print();
+        printf("\n");
+        lfsr.NextState();
+    }
+
+    printf("\n\nEnd queue demonstration...");
+
+    // Summarize what the queue operations above cost
+    if (Instrumentation::Enabled()) {
+        printf("\n\nInstrumentation summary:\n");
+        fflush(stdout);
+        Instrumentation::WriteCSV(cout);
+    } else {
+        printf("\n\n(Configure with -DCONTAINER_INSTRUMENTATION=ON for an instrumentation summary)\n");
+    }
+
+    return 0;
+}
@@ -8,21 +8,22 @@
 #include <iostream>
 #include <functional>
 #include <exception>
+#include "../../Common/instrumentation.h"
 
 // Exceptions
-struct QueueEmpty : public std::exception {
+struct QueueEmpty : public InstrumentedException<InstrumentedContainer::Queue> {
     const char* what() const noexcept override{
         return "Queue is empty.";
     }
 };
 
-struct QueueFull : public std::exception {
+struct QueueFull : public InstrumentedException<InstrumentedContainer::Queue> {
     const char* what() const noexcept override{
         return "Queue is full.";
     }
 };
 
-struct QueueInvalidPeek : public std::exception {
+struct QueueInvalidPeek : public InstrumentedException<InstrumentedContainer::Queue> {
     const char* what() const noexcept override{
         return "Peek node does not exist.";
     }
@@ -80,10 +81,14 @@ Queue::~Queue() {
 
 // Deallocates all queue nodes and returns queue to empty ready-to-use state
 void Queue::MakeEmpty() {
+    INSTRUMENT_OPERATION(Queue);
+
     std::function<void (Node*&)> EmptyRecursion = [&EmptyRecursion] (Node*& node) {
         if (node) {
+            INSTRUMENT_VISIT(Queue);
             EmptyRecursion(node->nextPtr);
-            delete[](node);
+            delete node;
+            INSTRUMENT_FREE(Queue, 1, sizeof(Node));
             node = nullptr;
         }
     };
@@ -95,12 +100,15 @@ void Queue::MakeEmpty() {
 // Adds value n to rear of queue and increments count.
 // If queue is already full, throws QueueFull exception
 void Queue::Enqueue(int n) {
+    INSTRUMENT_OPERATION(Queue);
+
     if (this->IsFull()) {
         throw QueueFull();
     }
 
     Node* tmpPtr = rearPtr;
     rearPtr = new Node;
+    INSTRUMENT_ALLOC(Queue, 1, sizeof(Node));
     rearPtr->data = n;
     rearPtr->nextPtr = tmpPtr;
     count++;
@@ -109,14 +117,18 @@ void Queue::Enqueue(int n) {
 // Removes front value from queue and decrements count.
 // If queue is empty, throws QueueEmpty exception
 void Queue::Dequeue() {
+    INSTRUMENT_OPERATION(Queue);
+
     if (this->IsEmpty()) {
         throw QueueEmpty();
     }
 
     // Iterate through the queue from rear to front and remove front
     std::function<void (Node*&)> DequeueRecursion = [&DequeueRecursion] (Node*& node) {
+        INSTRUMENT_VISIT(Queue);
         if (!node->nextPtr) {
-            delete[](node);
+            delete node;
+            INSTRUMENT_FREE(Queue, 1, sizeof(Node));
             node = nullptr;
         } else {
             DequeueRecursion(node->nextPtr);
@@ -130,11 +142,14 @@ void Queue::Dequeue() {
 // Returns integer from front of queue
 // If queue is empty, throws QueueEmpty exception
 int Queue::Front() const {
+    INSTRUMENT_OPERATION(Queue);
+
     if (this->IsEmpty()) {
         throw QueueEmpty();
     }
 
     std::function<int (Node*)> FrontRecursion = [&FrontRecursion] (Node* node) -> int{
+        INSTRUMENT_VISIT(Queue);
         if (!node->nextPtr){
             return node->data;
         } else {
@@ -148,9 +163,12 @@ int Queue::Front() const {
 // Returns integer from rear of queue
 // If queue is empty, throws QueueEmpty exception
 int Queue::Rear() const {
+    INSTRUMENT_OPERATION(Queue);
+
     if (this->IsEmpty()) {
         throw QueueEmpty();
     }
+    INSTRUMENT_VISIT(Queue);
     return rearPtr->data;
 }
 
@@ -158,6 +176,8 @@ int Queue::Rear() const {
 // If queue is empty, throws QueueEmpty
 // If position n does not exist, throws QueueInvalidPeek
 int Queue::Peek(int n) const {
+    INSTRUMENT_OPERATION(Queue);
+
     if (this->IsEmpty()) {
         throw QueueEmpty();
     } else if (n >= this->count) {
@@ -165,8 +185,10 @@ int Queue::Peek(int n) const {
     }
 
     Node* node = this->rearPtr;
+    INSTRUMENT_VISIT(Queue);
     for (int i = 0; i < this->count - n - 1; ++i) {
         node = node->nextPtr;
+        INSTRUMENT_VISIT(Queue);
     }
 
     return node->data;
@@ -3,24 +3,65 @@
 //
 // NOTES:
 // The public methods utilize several private helper methods to perform the desired tasks.
+// The Balance template parameter selects the balancing policy: NoBalance keeps the plain
+// BST shape, AVLBalance rotates on InsertItem/DeleteItem so the height stays O(log n).
+// Every node keeps a pointer to its parent, which lets const_iterator step through the tree in
+// order without a stack.  Update() relinks the children of each node it recomputes, so parent
+// pointers are repaired along the same path that heights and sizes are.
+// Nodes come from a per-tree NodeArena: they are bump-allocated in large blocks, deleted nodes are
+// recycled through a free list, and MakeEmpty() frees whole blocks instead of walking node by node.
+// FindMany() runs a group of lookups side by side, one level at a time, and prefetches each
+// lookup's next node before stepping the others, so the cache misses of the group overlap.
+// The Parallel* operations split work at subtrees larger than ParallelCutoff nodes and run the
+// halves on a ForkJoinPool.  Reductions always combine left, node, right in tree order, so their
+// result does not depend on how the work was scheduled.
+// Union, Intersection and Difference split this tree at each key of the other tree and join the
+// pieces back together, relinking existing nodes instead of inserting or deleting one key at a
+// time.  With m keys in the other tree and n in this one they take O(m log(n/m + 1)) steps, and
+// the two halves of each split are merged in parallel.
+// With CONTAINER_INSTRUMENTATION defined, the point operations (insert, delete, find, level,
+// parent) report their node visits, and the arena reports every node allocated and freed.
 //
 
 #ifndef BSTREE_H
 #define BSTREE_H
 
 #include <cstddef>
+#include <iterator>
 #include <new>
 #include <string>
 #include <queue>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "frozen_bstree.h"
+#include "node_arena.h"
+#include "fork_join.h"
+#include "../Common/instrumentation.h"
 
 using namespace std;
 
 // Exception classes
-class FullBSTree: public std::exception { };        // Exception class models full BSTree condition
-class EmptyBSTree: public std::exception  { };      // Exception class models empty BSTree condition
-class NotFoundBSTree: public std::exception  { };   // Exception class models not found in BSTree condition
-class FoundInBSTree: public std::exception  { };    // Exception class models found in BSTree condition
-class NoParentBSTree: public std::exception  { };   // Exception class models no parent in BSTree condition
+typedef InstrumentedException<InstrumentedContainer::BSTree> BSTreeException;
+
+class FullBSTree: public BSTreeException { };       // Exception class models full BSTree condition
+class EmptyBSTree: public BSTreeException  { };     // Exception class models empty BSTree condition
+class NotFoundBSTree: public BSTreeException  { };  // Exception class models not found in BSTree condition
+class FoundInBSTree: public BSTreeException  { };   // Exception class models found in BSTree condition
+class NoParentBSTree: public BSTreeException  { };  // Exception class models no parent in BSTree condition
+
+// Result of the non-throwing Try* operations; each non-Ok value matches one exception class above
+enum class BSTreeStatus {
+    Ok,                                 // Operation succeeded
+    Empty,                              // Tree is empty (EmptyBSTree)
+    NotFound,                           // Item is not in the tree (NotFoundBSTree)
+    NoParent                            // Item is the root and has no parent (NoParentBSTree)
+};
+
+
+// Balancing policies
+struct NoBalance { };                   // Plain BST, shape depends on insertion order
+struct AVLBalance { };                  // AVL tree, subtree heights differ by at most one
 
 
 template<typename SomeType>
@@ -28,282 +69,771 @@ struct BSTreeNode {                      // Node of BSTree
     SomeType data;                       // Data stored in node
     BSTreeNode<SomeType> *leftPtr;       // Pointer to left subtree
     BSTreeNode<SomeType> *rightPtr;      // Pointer to right subtree
+    BSTreeNode<SomeType> *parentPtr;     // Pointer to parent node (nullptr at the root)
+    int height;                          // Number of levels in subtree rooted at this node
+    int size;                            // Number of nodes in subtree rooted at this node
 };
 
-template<typename SomeType>
+template<typename SomeType, typename Balance = NoBalance>
 class BSTree {                         // BSTree Abstract Data Type
 private:
     BSTreeNode<SomeType> *rootPtr;       // Pointer to root of BSTree
-    void Delete(BSTreeNode<SomeType> *&treePtr, SomeType &item);
+    NodeArena<BSTreeNode<SomeType>> arena;   // Storage for every node of this tree
+    template<typename... Args>
+    BSTreeNode<SomeType> *NewNode(Args &&...args);
+    void FreeNode(BSTreeNode<SomeType> *treePtr);
+    static int Height(const BSTreeNode<SomeType> *treePtr);
+    static int Count(const BSTreeNode<SomeType> *treePtr);
+    static void Update(BSTreeNode<SomeType> *treePtr);
+    void RotateLeft(BSTreeNode<SomeType> *&treePtr);
+    void RotateRight(BSTreeNode<SomeType> *&treePtr);
+    void Rebalance(BSTreeNode<SomeType> *&treePtr);
+    bool Delete(BSTreeNode<SomeType> *&treePtr, const SomeType &item);
     void DeleteNode(BSTreeNode<SomeType> *&treePtr);
-    void Insert(BSTreeNode<SomeType> *&ptr, SomeType item);
-    void Destroy(BSTreeNode<SomeType> *&ptr);
+    void Insert(BSTreeNode<SomeType> *&ptr, BSTreeNode<SomeType> *newNode);
+    void InsertNode(BSTreeNode<SomeType> *newNode);
+    void Destroy();
     void CopyTree(BSTreeNode<SomeType> *&copy, const BSTreeNode<SomeType> *originalTree);
-    SomeType GetPredecessor(BSTreeNode<SomeType> *treePtr) const;
-    int CountNodes(BSTreeNode<SomeType> *treePtr) const;
-    int LevelCount(BSTreeNode<SomeType> *treePtr) const;
-    int FindLevel(BSTreeNode<SomeType> *treePtr, SomeType item) const;
-    void SearchForParent(BSTreeNode<SomeType> *treePtr, SomeType item) const;
+    BSTreeNode<SomeType> *BuildBalanced(vector<SomeType> &sorted, size_t first, size_t last);
+    void DeleteMax(BSTreeNode<SomeType> *&treePtr, SomeType &maxItem);
+    static constexpr int ParallelCutoff = 4096;    // Subtrees up to this size stay on one thread
+    static constexpr size_t FindManyGroup = 16;    // Lookups FindMany keeps in flight at once
+    template<typename NodeFn>
+    static void ForEachNodeParallel(BSTreeNode<SomeType> *treePtr, NodeFn &fn, ForkJoinPool &pool);
+    template<typename Result, typename Map, typename Combine>
+    static Result ReduceParallel(const BSTreeNode<SomeType> *treePtr, const Result &identity, Map &map,
+                                 Combine &combine, ForkJoinPool &pool);
+    BSTreeNode<SomeType> *CopyParallel(const BSTreeNode<SomeType> *originalTree, void **slots, ForkJoinPool &pool);
+    const BSTreeNode<SomeType> *FindNode(const SomeType &item) const;
+    BSTreeStatus FindParentNode(const SomeType &item, const BSTreeNode<SomeType> **parent) const;
+    BSTreeNode<SomeType> *Join(BSTreeNode<SomeType> *left, BSTreeNode<SomeType> *middle, BSTreeNode<SomeType> *right);
+    BSTreeNode<SomeType> *Join2(BSTreeNode<SomeType> *left, BSTreeNode<SomeType> *right);
+    BSTreeNode<SomeType> *SplitLast(BSTreeNode<SomeType> *treePtr, BSTreeNode<SomeType> *&last);
+    void Split(BSTreeNode<SomeType> *treePtr, const SomeType &key, BSTreeNode<SomeType> *&left,
+               BSTreeNode<SomeType> *&match, BSTreeNode<SomeType> *&right);
+    void FreeSubtree(BSTreeNode<SomeType> *treePtr);
+    template<typename Resolve>
+    BSTreeNode<SomeType> *UnionWith(BSTreeNode<SomeType> *treePtr, const BSTreeNode<SomeType> *other, void **slots,
+                                    Resolve &resolve, ForkJoinPool &pool);
+    template<typename Resolve>
+    BSTreeNode<SomeType> *IntersectWith(BSTreeNode<SomeType> *treePtr, const BSTreeNode<SomeType> *other,
+                                        BSTreeNode<SomeType> **gaps, Resolve &resolve, ForkJoinPool &pool);
+    BSTreeNode<SomeType> *DifferenceWith(BSTreeNode<SomeType> *treePtr, const BSTreeNode<SomeType> *other,
+                                         BSTreeNode<SomeType> **matches, ForkJoinPool &pool);
 
 public:
+    class const_iterator {             // Bidirectional in-order iterator over BSTree values
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = SomeType;
+        using difference_type = ptrdiff_t;
+        using pointer = const SomeType *;
+        using reference = const SomeType &;
+
+        const_iterator() : nodePtr(nullptr), tree(nullptr) { }
+        reference operator*() const { return nodePtr->data; }
+        pointer operator->() const { return &nodePtr->data; }
+        const_iterator &operator++();
+        const_iterator &operator--();
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+        const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+        bool operator==(const const_iterator &other) const { return nodePtr == other.nodePtr; }
+        bool operator!=(const const_iterator &other) const { return nodePtr != other.nodePtr; }
+
+    private:
+        friend class BSTree;
+        const_iterator(const BSTreeNode<SomeType> *node, const BSTree *owner) : nodePtr(node), tree(owner) { }
+        const BSTreeNode<SomeType> *nodePtr;     // Current node, nullptr at end()
+        const BSTree *tree;                      // Tree being iterated, used to step back from end()
+    };
+    using iterator = const_iterator;     // Stored values are ordered keys and are never modified in place
+
     BSTree();
-    BSTree(const BSTree<SomeType> &someTree);
-    void operator=(const BSTree<SomeType> &originalTree);
+    BSTree(const BSTree<SomeType, Balance> &someTree);
+    void operator=(const BSTree<SomeType, Balance> &originalTree);
     ~BSTree();
-    void InsertItem(SomeType item);
-    SomeType DeleteItem(SomeType item);
+    void InsertItem(const SomeType &item);
+    void InsertItem(SomeType &&item);
+    template<typename... Args>
+    void EmplaceItem(Args &&...args);
+    SomeType DeleteItem(const SomeType &item);
+    BSTreeStatus TryDelete(const SomeType &item);
     void MakeEmpty();
+    template<typename Range>
+    void BuildFrom(const Range &values);
+    void BuildFrom(vector<SomeType> &&values);
     int Size() const;
     bool IsFull() const;
     bool IsEmpty() const;
     SomeType Min() const;
     SomeType Max() const;
     int TotalLevels() const;
-    int Level(SomeType item) const;
-    SomeType Parent(SomeType item);
+    int Level(const SomeType &item) const;
+    BSTreeStatus TryLevel(const SomeType &item, int *level) const;
+    int Rank(const SomeType &item) const;
+    SomeType Select(int k) const;
+    const SomeType *Find(const SomeType &item) const;
+    void FindMany(const vector<SomeType> &keys, vector<const SomeType *> &out) const;
+    FrozenBSTree<SomeType> Freeze() const;
+    ArenaStats ArenaStatistics() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator LowerBound(const SomeType &item) const;
+    const_iterator UpperBound(const SomeType &item) const;
+    template<typename Visit>
+    void ForEachInRange(const SomeType &lo, const SomeType &hi, Visit visit) const;
+    SomeType Parent(const SomeType &item) const;
+    BSTreeStatus TryParent(const SomeType &item, SomeType *parent) const;
     void Print() const;
+    template<typename Visit>
+    void ParallelForEach(Visit visit, ForkJoinPool &pool = ForkJoinPool::Default()) const;
+    template<typename Result, typename Map, typename Combine>
+    Result ParallelReduce(Result identity, Map map, Combine combine, ForkJoinPool &pool = ForkJoinPool::Default()) const;
+    void ParallelCopy(const BSTree<SomeType, Balance> &originalTree, ForkJoinPool &pool = ForkJoinPool::Default());
+    void ParallelMakeEmpty(ForkJoinPool &pool = ForkJoinPool::Default());
+    template<typename Resolve>
+    void Union(const BSTree<SomeType, Balance> &other, Resolve resolve, ForkJoinPool &pool = ForkJoinPool::Default());
+    template<typename Resolve>
+    void Intersection(const BSTree<SomeType, Balance> &other, Resolve resolve,
+                      ForkJoinPool &pool = ForkJoinPool::Default());
+    void Difference(const BSTree<SomeType, Balance> &other, ForkJoinPool &pool = ForkJoinPool::Default());
 };
 
+// PreOrderVisit()
+// Calls visit on each tree item in preorder without copying the items.
+template<typename SomeType, typename Visit>
+void PreOrderVisit(const BSTreeNode<SomeType> *tree, Visit &visit) {
+    if (tree != nullptr) {
+        visit(tree->data);
+        PreOrderVisit(tree->leftPtr, visit);
+        PreOrderVisit(tree->rightPtr, visit);
+    }
+}
+
+// InOrderVisit()
+// Calls visit on each tree item in inorder without copying the items.
+template<typename SomeType, typename Visit>
+void InOrderVisit(const BSTreeNode<SomeType> *tree, Visit &visit) {
+    if (tree != nullptr) {
+        InOrderVisit(tree->leftPtr, visit);
+        visit(tree->data);
+        InOrderVisit(tree->rightPtr, visit);
+    }
+}
+
+// PostOrderVisit()
+// Calls visit on each tree item in postorder without copying the items.
+template<typename SomeType, typename Visit>
+void PostOrderVisit(const BSTreeNode<SomeType> *tree, Visit &visit) {
+    if (tree != nullptr) {
+        PostOrderVisit(tree->leftPtr, visit);
+        PostOrderVisit(tree->rightPtr, visit);
+        visit(tree->data);
+    }
+}
+
 // PreOrder()
 // Post: preorder contains the tree items in preorder.
 template<typename SomeType>
 void PreOrder(BSTreeNode<SomeType> *tree, queue<SomeType> &preorder) {
-    if (tree != NULL) {
-        preorder.push(tree->data);
-        PreOrder(tree->leftPtr, preorder);
-        PreOrder(tree->rightPtr, preorder);
-    }
+    auto push = [&preorder](const SomeType &data) { preorder.push(data); };
+    PreOrderVisit(tree, push);
 }
 
 // InOrder()
 // Post: inorder contains the tree items in inorder.
 template<typename SomeType>
 void InOrder(BSTreeNode<SomeType> *tree, queue<SomeType> &inorder) {
-    if (tree != NULL) {
-        InOrder(tree->leftPtr, inorder);
-        inorder.push(tree->data);
-        InOrder(tree->rightPtr, inorder);
-    }
+    auto push = [&inorder](const SomeType &data) { inorder.push(data); };
+    InOrderVisit(tree, push);
 }
 
 // PostOrder()
 // Post: postorder contains the tree items in postorder.
 template<typename SomeType>
 void PostOrder(BSTreeNode<SomeType> *tree, queue<SomeType> &postorder) {
-    if (tree != NULL) {
-        PostOrder(tree->leftPtr, postorder);
-        PostOrder(tree->rightPtr, postorder);
-        postorder.push(tree->data);
-    }
+    auto push = [&postorder](const SomeType &data) { postorder.push(data); };
+    PostOrderVisit(tree, push);
 }
 
 // Print()
 // Prints binary search tree contents in inorder, preorder, and postorder forms
-template<typename SomeType>
-void BSTree<SomeType>::Print() const {
-    queue<SomeType> preorder, inorder, postorder;
-
-    PreOrder(rootPtr, preorder);
-    InOrder(rootPtr, inorder);
-    PostOrder(rootPtr, postorder);
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Print() const {
+    auto print = [](const SomeType &data) { cout << data << " "; };
 
     cout << "Print() \n-- Inorder = { ";
-    while (!inorder.empty()) {
-        cout << inorder.front() << " ";
-        inorder.pop();
-    }
+    InOrderVisit(rootPtr, print);
     cout << "}   \n-- Preorder = { ";
-    while (!preorder.empty()) {
-        cout << preorder.front() << " ";
-        preorder.pop();
-    }
+    PreOrderVisit(rootPtr, print);
     cout << "}   \n-- Postorder = { ";
-    while (!postorder.empty()) {
-        cout << postorder.front() << " ";
-        postorder.pop();
-    }
+    PostOrderVisit(rootPtr, print);
     cout << "}" << endl;
 }
 
 /********  Start of Private Interface Functions  *********/
 
+// NewNode()
+// Constructs a leaf node in storage taken from the tree's arena, building its value in place from args
+template<typename SomeType, typename Balance>
+template<typename... Args>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::NewNode(Args &&...args) {
+    return new (this->arena.Allocate()) BSTreeNode<SomeType>{SomeType(std::forward<Args>(args)...),
+                                                             nullptr, nullptr, nullptr, 1, 1};
+}
+
+// FreeNode()
+// Destroys the node pointed to by treePtr and returns its storage to the arena's free list
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::FreeNode(BSTreeNode<SomeType> *treePtr) {
+    treePtr->~BSTreeNode<SomeType>();
+    this->arena.Release(treePtr);
+}
+
+// Height()
+// Returns the number of levels in the subtree pointed to by treePtr (0 for an empty subtree)
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::Height(const BSTreeNode<SomeType> *treePtr) {
+    return treePtr == nullptr ? 0 : treePtr->height;
+}
+
+// Count()
+// Returns the number of nodes in the subtree pointed to by treePtr (0 for an empty subtree)
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::Count(const BSTreeNode<SomeType> *treePtr) {
+    return treePtr == nullptr ? 0 : treePtr->size;
+}
+
+// Update()
+// Recomputes the cached height and size of treePtr from its children and points them back at treePtr
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Update(BSTreeNode<SomeType> *treePtr) {
+    if (treePtr->leftPtr != nullptr)
+        treePtr->leftPtr->parentPtr = treePtr;
+    if (treePtr->rightPtr != nullptr)
+        treePtr->rightPtr->parentPtr = treePtr;
+    treePtr->height = 1 + max(Height(treePtr->leftPtr), Height(treePtr->rightPtr));
+    treePtr->size = 1 + Count(treePtr->leftPtr) + Count(treePtr->rightPtr);
+}
+
+// RotateLeft()
+// Makes the right child of treePtr the new root of the subtree and updates both nodes
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::RotateLeft(BSTreeNode<SomeType> *&treePtr) {
+    BSTreeNode<SomeType> *pivot = treePtr->rightPtr;
+
+    treePtr->rightPtr = pivot->leftPtr;
+    pivot->leftPtr = treePtr;
+    Update(treePtr);
+    Update(pivot);
+    treePtr = pivot;
+}
+
+// RotateRight()
+// Makes the left child of treePtr the new root of the subtree and updates both nodes
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::RotateRight(BSTreeNode<SomeType> *&treePtr) {
+    BSTreeNode<SomeType> *pivot = treePtr->leftPtr;
+
+    treePtr->leftPtr = pivot->rightPtr;
+    pivot->rightPtr = treePtr;
+    Update(treePtr);
+    Update(pivot);
+    treePtr = pivot;
+}
+
+// Rebalance()
+// Recomputes the height and size of treePtr after one of its subtrees changed
+// Under AVLBalance, also performs the single or double rotation that restores the AVL property
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Rebalance(BSTreeNode<SomeType> *&treePtr) {
+    Update(treePtr);
+
+    if (!is_same<Balance, AVLBalance>::value)
+        return;
+
+    int balance = Height(treePtr->leftPtr) - Height(treePtr->rightPtr);
+
+    if (balance > 1) {
+        // Left heavy; a left-right case is first turned into a left-left case
+        if (Height(treePtr->leftPtr->leftPtr) < Height(treePtr->leftPtr->rightPtr))
+            RotateLeft(treePtr->leftPtr);
+        RotateRight(treePtr);
+    } else if (balance < -1) {
+        // Right heavy; a right-left case is first turned into a right-right case
+        if (Height(treePtr->rightPtr->rightPtr) < Height(treePtr->rightPtr->leftPtr))
+            RotateRight(treePtr->rightPtr);
+        RotateLeft(treePtr);
+    }
+}
+
 // Delete()
 // Recursive function that traverses the tree starting at treePtr to locate the data value to be removed
 // Once located, DeleteNode is invoked to remove the value from the tree
-// If tree is not empty and item is NOT present, throw NotFoundBSTree
-template<typename SomeType>
-void BSTree<SomeType>::Delete(BSTreeNode<SomeType> *&treePtr, SomeType &item) {
-    if (item < treePtr->data)
-        Delete(treePtr->leftPtr, item);
-    else if (item > treePtr->data)
-        Delete(treePtr->rightPtr, item);
-    else
+// Returns false, leaving the tree unchanged, if item is NOT present
+template<typename SomeType, typename Balance>
+bool BSTree<SomeType, Balance>::Delete(BSTreeNode<SomeType> *&treePtr, const SomeType &item) {
+    if (treePtr == nullptr)
+        return false;
+
+    INSTRUMENT_VISIT(BSTree);
+
+    if (item < treePtr->data) {
+        if (!Delete(treePtr->leftPtr, item))
+            return false;
+    } else if (item > treePtr->data) {
+        if (!Delete(treePtr->rightPtr, item))
+            return false;
+    } else {
         DeleteNode(treePtr);
+    }
+
+    if (treePtr != nullptr)
+        Rebalance(treePtr);
+
+    return true;
 }
 
 // DeleteNode()
 // Removes the node pointed to by treePtr from the tree
-template<typename SomeType>
-void BSTree<SomeType>::DeleteNode(BSTreeNode<SomeType> *&treePtr) {
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::DeleteNode(BSTreeNode<SomeType> *&treePtr) {
     if (treePtr->rightPtr == nullptr && treePtr->leftPtr == nullptr) {
-        delete treePtr;
+        FreeNode(treePtr);
         treePtr = nullptr;
     } else if (treePtr->leftPtr == nullptr) {
         BSTreeNode<SomeType> *tmp = treePtr;
         treePtr = treePtr->rightPtr;
-        delete tmp;
+        FreeNode(tmp);
     } else if (treePtr->rightPtr == nullptr) {
         BSTreeNode<SomeType> *tmp = treePtr;
         treePtr = treePtr->leftPtr;
-        delete tmp;
+        FreeNode(tmp);
     } else {
-        // Two Children
-        SomeType tmp = GetPredecessor(treePtr->leftPtr);
-        treePtr->data = tmp;
-        Delete(treePtr->leftPtr, tmp);  // Delete duplicate that was just made
+        // Two Children: the predecessor is moved up from the left subtree
+        DeleteMax(treePtr->leftPtr, treePtr->data);
     }
 }
 
 // Insert()
-// Recursive function that finds the correct position of item and adds it to the tree
-// Throws FoundInBSTree if item is already in the tree
-template<typename SomeType>
-void BSTree<SomeType>::Insert(BSTreeNode<SomeType> *&ptr, SomeType item) {
+// Recursive function that finds the correct position of newNode's value and links newNode there
+// Throws FoundInBSTree if the value is already in the tree
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Insert(BSTreeNode<SomeType> *&ptr, BSTreeNode<SomeType> *newNode) {
     if (ptr == nullptr) {
-        auto *newNode = new BSTreeNode<SomeType>;
-        *newNode = {item, nullptr, nullptr};
         ptr = newNode;
-    } else if (item < ptr->data) {
-        Insert(ptr->leftPtr, item);
-    } else if (item > ptr->data) {
-        Insert(ptr->rightPtr, item);
+        return;
+    }
+
+    INSTRUMENT_VISIT(BSTree);
+    if (newNode->data < ptr->data) {
+        Insert(ptr->leftPtr, newNode);
+    } else if (newNode->data > ptr->data) {
+        Insert(ptr->rightPtr, newNode);
     } else {
         // Item to insert must be equal to the current item
         throw FoundInBSTree();
     }
 
+    Rebalance(ptr);
+}
+
+// InsertNode()
+// Links an already constructed node into the tree, freeing it again if its value is a duplicate
+// Throws FoundInBSTree if the value is already in the tree
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::InsertNode(BSTreeNode<SomeType> *newNode) {
+    try {
+        Insert(this->rootPtr, newNode);
+    } catch (FoundInBSTree &) {
+        FreeNode(newNode);
+        throw;
+    }
+
+    this->rootPtr->parentPtr = nullptr;
 }
 
 // Destroy()
-// Recursively deallocates every node in the tree pointed to by ptr
-template<typename SomeType>
-void BSTree<SomeType>::Destroy(BSTreeNode<SomeType> *&ptr) {
-    if (ptr->rightPtr == nullptr && ptr->leftPtr == nullptr) {
-        DeleteNode(ptr);
-    } else if (ptr->rightPtr == nullptr) {
-        Destroy(ptr->leftPtr);
-        DeleteNode(ptr);
-    } else if (ptr->leftPtr == nullptr) {
-        Destroy(ptr->rightPtr);
-        DeleteNode(ptr);
-    } else {
-        // Two children
-        Destroy(ptr->rightPtr);
-        Destroy(ptr->leftPtr);
-        DeleteNode(ptr);
+// Deallocates every node in the tree and sets root pointer to NULL
+// Destructors of the stored values still run (walking the tree in order through parent pointers);
+// the node storage itself is returned to the heap a whole block at a time
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Destroy() {
+    if (!is_trivially_destructible<SomeType>::value && this->rootPtr != nullptr) {
+        BSTreeNode<SomeType> *tmp = this->rootPtr;
+
+        while (tmp->leftPtr != nullptr)
+            tmp = tmp->leftPtr;
+
+        // Only the link fields are read after a node's data is destroyed
+        while (tmp != nullptr) {
+            BSTreeNode<SomeType> *next;
+
+            if (tmp->rightPtr != nullptr) {
+                next = tmp->rightPtr;
+                while (next->leftPtr != nullptr)
+                    next = next->leftPtr;
+            } else {
+                const BSTreeNode<SomeType> *child = tmp;
+                next = tmp->parentPtr;
+                while (next != nullptr && next->rightPtr == child) {
+                    child = next;
+                    next = next->parentPtr;
+                }
+            }
+
+            tmp->data.~SomeType();
+            tmp = next;
+        }
     }
+
+    this->arena.Clear();
+    this->rootPtr = nullptr;
 }
 
 // CopyTree()
 // Recursively copies all data from original tree into copy
-template<typename SomeType>
-void BSTree<SomeType>::CopyTree(BSTreeNode<SomeType> *&copy, const BSTreeNode<SomeType> *originalTree) {
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::CopyTree(BSTreeNode<SomeType> *&copy, const BSTreeNode<SomeType> *originalTree) {
     if (originalTree == nullptr) {
         copy = nullptr;
     } else {
-        copy = new BSTreeNode<SomeType>;
-        copy->data = originalTree->data;
-        copy->leftPtr = originalTree->leftPtr;
-        copy->rightPtr = originalTree->rightPtr;
-
+        copy = NewNode(originalTree->data);
         CopyTree(copy->leftPtr, originalTree->leftPtr);
         CopyTree( copy->rightPtr, originalTree->rightPtr);
+        Update(copy);
     }
 }
 
-// GetPredecessor()
-// Finds the largest data value in the tree pointed to by treePtr and returns that data value
-template<typename SomeType>
-SomeType BSTree<SomeType>::GetPredecessor(BSTreeNode<SomeType> *treePtr) const {
-    BSTreeNode<SomeType> *tmp = treePtr;
+// BuildBalanced()
+// Recursively builds a perfectly balanced subtree from sorted[first..last) with the middle value
+// at the subtree root; returns the subtree root (nullptr for an empty range)
+// The values are moved into the nodes, leaving sorted[first..last) in a moved-from state
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::BuildBalanced(vector<SomeType> &sorted, size_t first, size_t last) {
+    if (first == last)
+        return nullptr;
 
-    while (tmp->rightPtr != nullptr) {
-        tmp = tmp->rightPtr;
+    size_t middle = first + (last - first) / 2;
+    BSTreeNode<SomeType> *node = NewNode(std::move(sorted[middle]));
+
+    node->leftPtr = BuildBalanced(sorted, first, middle);
+    node->rightPtr = BuildBalanced(sorted, middle + 1, last);
+    Update(node);
+
+    return node;
+}
+
+// ForEachNodeParallel()
+// Calls fn(node) for every node of the subtree pointed to by treePtr, after both of the node's
+// subtrees are done; subtrees larger than ParallelCutoff are processed in parallel
+template<typename SomeType, typename Balance>
+template<typename NodeFn>
+void BSTree<SomeType, Balance>::ForEachNodeParallel(BSTreeNode<SomeType> *treePtr, NodeFn &fn, ForkJoinPool &pool) {
+    if (treePtr == nullptr)
+        return;
+
+    if (treePtr->size > ParallelCutoff) {
+        pool.Invoke([&] { ForEachNodeParallel(treePtr->leftPtr, fn, pool); },
+                    [&] { ForEachNodeParallel(treePtr->rightPtr, fn, pool); });
+    } else {
+        ForEachNodeParallel(treePtr->leftPtr, fn, pool);
+        ForEachNodeParallel(treePtr->rightPtr, fn, pool);
     }
 
-    return tmp->data;
+    fn(treePtr);
 }
 
-// CountNodes()
-// Recursive function that counts every node in the tree pointed to by treePtr and returns the count
-template<typename SomeType>
-int BSTree<SomeType>::CountNodes(BSTreeNode<SomeType> *treePtr) const {
-    if (treePtr->rightPtr == nullptr && treePtr->leftPtr == nullptr)
-        return 1;
-    else if (treePtr->leftPtr == nullptr)
-        return 1 + CountNodes(treePtr->rightPtr);
-    else if (treePtr->rightPtr == nullptr)
-        return 1 + CountNodes(treePtr->leftPtr);
-    else
-        // Two children
-        return 1 + CountNodes(treePtr->rightPtr) + CountNodes(treePtr->leftPtr);
-}
-
-// LevelCount()
-// Recursive function that traverses the entire tree to determine the total number of levels in the tree
-template<typename SomeType>
-int BSTree<SomeType>::LevelCount(BSTreeNode<SomeType> *treePtr) const {
-    if (treePtr->rightPtr == nullptr && treePtr->leftPtr == nullptr)
-        return 1;
-    else if (treePtr->rightPtr == nullptr)
-        return 1 + LevelCount(treePtr->leftPtr);
-    if (treePtr->leftPtr == nullptr)
-        return 1 + LevelCount(treePtr->rightPtr);
-    else
-        return 1 + max(LevelCount(treePtr->leftPtr), LevelCount(treePtr->rightPtr));
-}
-
-// FindLevel()
-// Recursive function that traverses the tree looking for item and returns the level where
-// item was found
-template<typename SomeType>
-int BSTree<SomeType>::FindLevel(BSTreeNode<SomeType> *treePtr, SomeType item) const {
+// ReduceParallel()
+// Returns combine(combine(reduce(left), map(data)), reduce(right)) for the subtree pointed to by
+// treePtr, or identity for an empty subtree; subtrees larger than ParallelCutoff are reduced in parallel
+template<typename SomeType, typename Balance>
+template<typename Result, typename Map, typename Combine>
+Result BSTree<SomeType, Balance>::ReduceParallel(const BSTreeNode<SomeType> *treePtr, const Result &identity, Map &map,
+                                                 Combine &combine, ForkJoinPool &pool) {
     if (treePtr == nullptr)
-        throw NotFoundBSTree();
-    else if (treePtr->data == item)
-        return 0;
-    else if(treePtr->data < item)
-        return 1 + FindLevel(treePtr->rightPtr, item);
-    else
-        return 1 + FindLevel(treePtr->leftPtr, item);
+        return identity;
+
+    Result left = identity;
+    Result right = identity;
+
+    if (treePtr->size > ParallelCutoff) {
+        pool.Invoke([&] { left = ReduceParallel(treePtr->leftPtr, identity, map, combine, pool); },
+                    [&] { right = ReduceParallel(treePtr->rightPtr, identity, map, combine, pool); });
+    } else {
+        left = ReduceParallel(treePtr->leftPtr, identity, map, combine, pool);
+        right = ReduceParallel(treePtr->rightPtr, identity, map, combine, pool);
+    }
+
+    return combine(combine(left, map(treePtr->data)), right);
 }
 
-// SearchForParent()
-// Recursive function that traverses the tree looking for item's parent and throws the value of
-// item's parent if found.  Otherwise, throws NotFoundBSTree
-template<typename SomeType>
-void BSTree<SomeType>::SearchForParent(BSTreeNode<SomeType> *treePtr, SomeType item) const {
-   if (treePtr->rightPtr == nullptr && treePtr->leftPtr == nullptr){
-   } else if (treePtr->rightPtr == nullptr) {
-        if (treePtr->leftPtr->data == item)
-            throw *treePtr;
-        else
-            SearchForParent(treePtr->leftPtr, item);
-    } else if (treePtr->leftPtr == nullptr) {
-        if (treePtr->rightPtr->data == item)
-            throw *treePtr;
-        else
-            SearchForParent(treePtr->rightPtr, item);
+// CopyParallel()
+// Copies the subtree originalTree into the preallocated node storage slots, laid out in preorder,
+// and returns the copy's root; subtrees larger than ParallelCutoff are copied in parallel
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::CopyParallel(const BSTreeNode<SomeType> *originalTree, void **slots,
+                                                              ForkJoinPool &pool) {
+    if (originalTree == nullptr)
+        return nullptr;
+
+    auto *copy = new (slots[0]) BSTreeNode<SomeType>{originalTree->data, nullptr, nullptr, nullptr, 1, 1};
+    void **leftSlots = slots + 1;
+    void **rightSlots = leftSlots + Count(originalTree->leftPtr);
+
+    if (originalTree->size > ParallelCutoff) {
+        pool.Invoke([&] { copy->leftPtr = CopyParallel(originalTree->leftPtr, leftSlots, pool); },
+                    [&] { copy->rightPtr = CopyParallel(originalTree->rightPtr, rightSlots, pool); });
     } else {
-        // Two children
-        if (treePtr->rightPtr->data == item || treePtr->leftPtr->data == item) {
-            throw *treePtr;
-        } else {
-            SearchForParent(treePtr->leftPtr, item);
-            SearchForParent(treePtr->rightPtr, item);
+        copy->leftPtr = CopyParallel(originalTree->leftPtr, leftSlots, pool);
+        copy->rightPtr = CopyParallel(originalTree->rightPtr, rightSlots, pool);
+    }
+    Update(copy);
+
+    return copy;
+}
+
+// DeleteMax()
+// Moves the largest data value in the non-empty tree pointed to by treePtr into maxItem and
+// removes its node, rebalancing on the way back up
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::DeleteMax(BSTreeNode<SomeType> *&treePtr, SomeType &maxItem) {
+    if (treePtr->rightPtr == nullptr) {
+        BSTreeNode<SomeType> *tmp = treePtr;
+        maxItem = std::move(tmp->data);
+        treePtr = tmp->leftPtr;
+        FreeNode(tmp);
+        return;
+    }
+
+    DeleteMax(treePtr->rightPtr, maxItem);
+    Rebalance(treePtr);
+}
+
+// FindNode()
+// Descends from the root following the ordering and returns the node holding item, or nullptr
+template<typename SomeType, typename Balance>
+const BSTreeNode<SomeType> *BSTree<SomeType, Balance>::FindNode(const SomeType &item) const {
+    const BSTreeNode<SomeType> *tmp = this->rootPtr;
+
+    while (tmp != nullptr) {
+        INSTRUMENT_VISIT(BSTree);
+        if (item < tmp->data)
+            tmp = tmp->leftPtr;
+        else if (item > tmp->data)
+            tmp = tmp->rightPtr;
+        else
+            return tmp;
+    }
+
+    return nullptr;
+}
+
+// FindParentNode()
+// Stores a pointer to the node holding item's parent in *parent, reporting the outcome like TryParent
+template<typename SomeType, typename Balance>
+BSTreeStatus BSTree<SomeType, Balance>::FindParentNode(const SomeType &item, const BSTreeNode<SomeType> **parent) const {
+    INSTRUMENT_OPERATION(BSTree);
+
+    if (this->IsEmpty())
+        return BSTreeStatus::Empty;
+
+    const BSTreeNode<SomeType> *node = FindNode(item);
+
+    if (node == nullptr)
+        return BSTreeStatus::NotFound;
+    if (node->parentPtr == nullptr)
+        return BSTreeStatus::NoParent;
+
+    *parent = node->parentPtr;
+    return BSTreeStatus::Ok;
+}
+
+// Join()
+// Returns a tree holding left, then middle, then right, where every value in left is less than
+// middle's and every value in right is greater; under AVLBalance middle is hung at the point on
+// the taller tree's inner spine where the heights match and the path up is rebalanced
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::Join(BSTreeNode<SomeType> *left, BSTreeNode<SomeType> *middle,
+                                                      BSTreeNode<SomeType> *right) {
+    if (is_same<Balance, AVLBalance>::value) {
+        if (Height(left) > Height(right) + 1) {
+            left->rightPtr = Join(left->rightPtr, middle, right);
+            Rebalance(left);
+            return left;
+        }
+        if (Height(right) > Height(left) + 1) {
+            right->leftPtr = Join(left, middle, right->leftPtr);
+            Rebalance(right);
+            return right;
         }
     }
 
+    middle->leftPtr = left;
+    middle->rightPtr = right;
+    Update(middle);
+
+    return middle;
+}
+
+// Join2()
+// Same as Join(), but without a middle node; the maximum of left is used in its place
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::Join2(BSTreeNode<SomeType> *left, BSTreeNode<SomeType> *right) {
+    if (left == nullptr)
+        return right;
+
+    BSTreeNode<SomeType> *last;
+    BSTreeNode<SomeType> *rest = SplitLast(left, last);
+
+    return Join(rest, last, right);
+}
+
+// SplitLast()
+// Detaches the node holding the maximum value of the non-empty tree treePtr into last and
+// returns the tree of the remaining nodes
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::SplitLast(BSTreeNode<SomeType> *treePtr, BSTreeNode<SomeType> *&last) {
+    if (treePtr->rightPtr == nullptr) {
+        last = treePtr;
+        return treePtr->leftPtr;
+    }
+
+    BSTreeNode<SomeType> *rest = SplitLast(treePtr->rightPtr, last);
+
+    return Join(treePtr->leftPtr, treePtr, rest);
+}
+
+// Split()
+// Takes apart the tree treePtr into the values less than key (left), the node equal to key
+// (match, or nullptr if there is none) and the values greater than key (right)
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Split(BSTreeNode<SomeType> *treePtr, const SomeType &key, BSTreeNode<SomeType> *&left,
+                                      BSTreeNode<SomeType> *&match, BSTreeNode<SomeType> *&right) {
+    if (treePtr == nullptr) {
+        left = match = right = nullptr;
+    } else if (key < treePtr->data) {
+        BSTreeNode<SomeType> *rest;
+        Split(treePtr->leftPtr, key, left, match, rest);
+        right = Join(rest, treePtr, treePtr->rightPtr);
+    } else if (key > treePtr->data) {
+        BSTreeNode<SomeType> *rest;
+        Split(treePtr->rightPtr, key, rest, match, right);
+        left = Join(treePtr->leftPtr, treePtr, rest);
+    } else {
+        left = treePtr->leftPtr;
+        right = treePtr->rightPtr;
+        match = treePtr;
+    }
+}
+
+// FreeSubtree()
+// Frees every node of the subtree pointed to by treePtr
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::FreeSubtree(BSTreeNode<SomeType> *treePtr) {
+    if (treePtr != nullptr) {
+        FreeSubtree(treePtr->leftPtr);
+        FreeSubtree(treePtr->rightPtr);
+        FreeNode(treePtr);
+    }
+}
+
+// UnionWith()
+// Returns the union of the subtree treePtr with a copy of the subtree other; equal values are
+// replaced by resolve(mine, theirs).  slots holds preallocated storage for other's nodes in
+// order; each slot used for a new node is set to nullptr.  Large subtrees are merged in parallel
+template<typename SomeType, typename Balance>
+template<typename Resolve>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::UnionWith(BSTreeNode<SomeType> *treePtr, const BSTreeNode<SomeType> *other,
+                                                           void **slots, Resolve &resolve, ForkJoinPool &pool) {
+    if (other == nullptr)
+        return treePtr;
+
+    BSTreeNode<SomeType> *left, *match, *right;
+    void **middleSlot = slots + Count(other->leftPtr);
+
+    Split(treePtr, other->data, left, match, right);
+
+    if (Count(left) + Count(right) + other->size > ParallelCutoff) {
+        pool.Invoke([&] { left = UnionWith(left, other->leftPtr, slots, resolve, pool); },
+                    [&] { right = UnionWith(right, other->rightPtr, middleSlot + 1, resolve, pool); });
+    } else {
+        left = UnionWith(left, other->leftPtr, slots, resolve, pool);
+        right = UnionWith(right, other->rightPtr, middleSlot + 1, resolve, pool);
+    }
+
+    if (match != nullptr) {
+        match->data = resolve(static_cast<const SomeType &>(match->data), other->data);
+    } else {
+        match = new (*middleSlot) BSTreeNode<SomeType>{other->data, nullptr, nullptr, nullptr, 1, 1};
+        *middleSlot = nullptr;
+    }
+
+    return Join(left, match, right);
+}
+
+// IntersectWith()
+// Returns the values of the subtree treePtr that are also in the subtree other, each replaced by
+// resolve(mine, theirs).  Subtrees of treePtr that fall between two consecutive values of other
+// are unlinked into gaps (one entry per gap, in order) for the caller to free
+template<typename SomeType, typename Balance>
+template<typename Resolve>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::IntersectWith(BSTreeNode<SomeType> *treePtr,
+                                                               const BSTreeNode<SomeType> *other,
+                                                               BSTreeNode<SomeType> **gaps, Resolve &resolve,
+                                                               ForkJoinPool &pool) {
+    if (treePtr == nullptr)
+        return nullptr;
+    if (other == nullptr) {
+        gaps[0] = treePtr;
+        return nullptr;
+    }
+
+    BSTreeNode<SomeType> *left, *match, *right;
+    BSTreeNode<SomeType> **rightGaps = gaps + Count(other->leftPtr) + 1;
+
+    Split(treePtr, other->data, left, match, right);
+
+    if (Count(left) + Count(right) + other->size > ParallelCutoff) {
+        pool.Invoke([&] { left = IntersectWith(left, other->leftPtr, gaps, resolve, pool); },
+                    [&] { right = IntersectWith(right, other->rightPtr, rightGaps, resolve, pool); });
+    } else {
+        left = IntersectWith(left, other->leftPtr, gaps, resolve, pool);
+        right = IntersectWith(right, other->rightPtr, rightGaps, resolve, pool);
+    }
+
+    if (match == nullptr)
+        return Join2(left, right);
+
+    match->data = resolve(static_cast<const SomeType &>(match->data), other->data);
+    return Join(left, match, right);
+}
+
+// DifferenceWith()
+// Returns the values of the subtree treePtr that are not in the subtree other.  The node matching
+// each value of other is unlinked into matches (indexed by that value's in-order position in
+// other) for the caller to free
+template<typename SomeType, typename Balance>
+BSTreeNode<SomeType> *BSTree<SomeType, Balance>::DifferenceWith(BSTreeNode<SomeType> *treePtr,
+                                                                const BSTreeNode<SomeType> *other,
+                                                                BSTreeNode<SomeType> **matches, ForkJoinPool &pool) {
+    if (treePtr == nullptr || other == nullptr)
+        return treePtr;
+
+    BSTreeNode<SomeType> *left, *right;
+    BSTreeNode<SomeType> **middle = matches + Count(other->leftPtr);
+
+    Split(treePtr, other->data, left, *middle, right);
+
+    if (Count(left) + Count(right) + other->size > ParallelCutoff) {
+        pool.Invoke([&] { left = DifferenceWith(left, other->leftPtr, matches, pool); },
+                    [&] { right = DifferenceWith(right, other->rightPtr, middle + 1, pool); });
+    } else {
+        left = DifferenceWith(left, other->leftPtr, matches, pool);
+        right = DifferenceWith(right, other->rightPtr, middle + 1, pool);
+    }
+
+    return Join2(left, right);
 }
 
 /********  End of Private Interface Functions  *********/
@@ -313,96 +843,300 @@ void BSTree<SomeType>::SearchForParent(BSTreeNode<SomeType> *treePtr, SomeType i
 
 // BSTree()
 // Default constructor initializes root pointer to NULL
-template<typename SomeType>
-BSTree<SomeType>::BSTree() {
+template<typename SomeType, typename Balance>
+BSTree<SomeType, Balance>::BSTree() {
     this->rootPtr = nullptr;
 }
 
 // BSTree()
 // Copy constructor for BSTree
-template<typename SomeType>
-BSTree<SomeType>::BSTree(const BSTree<SomeType> &someTree) {
+template<typename SomeType, typename Balance>
+BSTree<SomeType, Balance>::BSTree(const BSTree<SomeType, Balance> &someTree) {
     CopyTree(this->rootPtr, someTree.rootPtr);
 }
 
 // operator=()
 // Overloaded assignment operator for BSTree.
-template<typename SomeType>
-void BSTree<SomeType>::operator=(const BSTree<SomeType> &originalTree) {
+// Deallocates the current nodes before deep-copying originalTree
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::operator=(const BSTree<SomeType, Balance> &originalTree) {
+    if (this == &originalTree)
+        return;
+
+    Destroy();
     CopyTree(this->rootPtr, originalTree.rootPtr);
 }
 
 // ~BSTree()
 // Destructor deallocates all tree nodes
-template<typename SomeType>
-BSTree<SomeType>::~BSTree() {
-    if (!this->IsEmpty())
-        Destroy(this->rootPtr);
+template<typename SomeType, typename Balance>
+BSTree<SomeType, Balance>::~BSTree() {
+    Destroy();
 }
 
 // InsertItem()
 // Inserts item into BSTree;  if tree already full, throws FullBSTree exception
 // If item is already in BSTree, throw FoundInBSTree exception
-template<typename SomeType>
-void BSTree<SomeType>::InsertItem(SomeType item) {
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::InsertItem(const SomeType &item) {
+    INSTRUMENT_OPERATION(BSTree);
+
     if (this->IsFull())
-        throw FoundInBSTree();
+        throw FullBSTree();
+
+    InsertNode(NewNode(item));
+}
+
+// InsertItem()
+// Same as above, but moves item into the tree instead of copying it
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::InsertItem(SomeType &&item) {
+    INSTRUMENT_OPERATION(BSTree);
+
+    if (this->IsFull())
+        throw FullBSTree();
+
+    InsertNode(NewNode(std::move(item)));
+}
+
+// EmplaceItem()
+// Inserts the value SomeType(args...), constructed directly inside its tree node
+// Throws the same exceptions as InsertItem
+template<typename SomeType, typename Balance>
+template<typename... Args>
+void BSTree<SomeType, Balance>::EmplaceItem(Args &&...args) {
+    INSTRUMENT_OPERATION(BSTree);
 
-    Insert(this->rootPtr, item);
+    if (this->IsFull())
+        throw FullBSTree();
+
+    InsertNode(NewNode(std::forward<Args>(args)...));
 }
 
 // DeleteItem()
 // Deletes item from BSTree if item is present AND returns object
 // If tree is empty, throw the EmptyBSTree exception
 // If tree is not empty and item is NOT present, throw NotFoundBSTree
-template<typename SomeType>
-SomeType BSTree<SomeType>::DeleteItem(SomeType item) {
+template<typename SomeType, typename Balance>
+SomeType BSTree<SomeType, Balance>::DeleteItem(const SomeType &item) {
+    switch (TryDelete(item)) {
+        case BSTreeStatus::Empty:
+            throw EmptyBSTree();
+        case BSTreeStatus::NotFound:
+            throw NotFoundBSTree();
+        default:
+            return item;
+    }
+}
+
+// TryDelete()
+// Deletes item from BSTree if item is present, reporting the outcome instead of throwing
+// Returns Empty if the tree is empty and NotFound if item is not present
+template<typename SomeType, typename Balance>
+BSTreeStatus BSTree<SomeType, Balance>::TryDelete(const SomeType &item) {
+    INSTRUMENT_OPERATION(BSTree);
+
     if (this->IsEmpty())
-        throw EmptyBSTree();
+        return BSTreeStatus::Empty;
 
-    SomeType itemCopy = item;
+    if (!Delete(this->rootPtr, item))
+        return BSTreeStatus::NotFound;
 
-    Delete(this->rootPtr, item);
+    if (this->rootPtr != nullptr)
+        this->rootPtr->parentPtr = nullptr;
 
-    return itemCopy;
+    return BSTreeStatus::Ok;
 }
 
 // MakeEmpty()
 // Deallocates all BSTree nodes and sets root pointer to NULL
-template<typename SomeType>
-void BSTree<SomeType>::MakeEmpty() {
-    if (!this->IsEmpty())
-        Destroy(this->rootPtr);
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::MakeEmpty() {
+    Destroy();
+}
+
+// ArenaStatistics()
+// Returns block, capacity, live/free node and fragmentation figures for the tree's node arena
+template<typename SomeType, typename Balance>
+ArenaStats BSTree<SomeType, Balance>::ArenaStatistics() const {
+    return this->arena.Stats();
+}
+
+// BuildFrom()
+// Replaces the tree contents with the values in range, building a perfectly balanced tree
+// Runs in O(n) when the values are already ascending and O(n log n) otherwise; when several
+// values compare equal only the first one in range is kept
+template<typename SomeType, typename Balance>
+template<typename Range>
+void BSTree<SomeType, Balance>::BuildFrom(const Range &values) {
+    BuildFrom(vector<SomeType>(std::begin(values), std::end(values)));
+}
+
+// BuildFrom()
+// Same as above, but takes ownership of the values instead of copying them
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::BuildFrom(vector<SomeType> &&values) {
+    auto equal = [](const SomeType &a, const SomeType &b) { return !(a < b) && !(b < a); };
+
+    if (!is_sorted(values.begin(), values.end()))
+        stable_sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end(), equal), values.end());
+
+    Destroy();
+    this->rootPtr = BuildBalanced(values, 0, values.size());
+}
+
+// ParallelForEach()
+// Calls visit(value) for every value, spreading subtrees across pool's threads
+// visit may run concurrently on several threads and in no particular order
+template<typename SomeType, typename Balance>
+template<typename Visit>
+void BSTree<SomeType, Balance>::ParallelForEach(Visit visit, ForkJoinPool &pool) const {
+    auto visitNode = [&visit](const BSTreeNode<SomeType> *treePtr) { visit(treePtr->data); };
+
+    ForEachNodeParallel(this->rootPtr, visitNode, pool);
+}
+
+// ParallelReduce()
+// Returns the combination of map(value) over all values in ascending order, for an associative
+// combine with identity as its neutral element; e.g. the sum of all item prices
+// The grouping follows the tree shape, so repeated calls on the same tree give identical results
+template<typename SomeType, typename Balance>
+template<typename Result, typename Map, typename Combine>
+Result BSTree<SomeType, Balance>::ParallelReduce(Result identity, Map map, Combine combine, ForkJoinPool &pool) const {
+    return ReduceParallel(this->rootPtr, identity, map, combine, pool);
+}
+
+// ParallelCopy()
+// Replaces the tree contents with a copy of originalTree, building subtrees in parallel
+// Node storage is taken from the arena up front so the copy itself needs no locking
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::ParallelCopy(const BSTree<SomeType, Balance> &originalTree, ForkJoinPool &pool) {
+    if (this == &originalTree)
+        return;
+
+    vector<void *> slots(originalTree.Size());
+
+    Destroy();
+    for (void *&slot : slots)
+        slot = this->arena.Allocate();
+
+    this->rootPtr = CopyParallel(originalTree.rootPtr, slots.data(), pool);
+}
+
+// ParallelMakeEmpty()
+// Deallocates all BSTree nodes like MakeEmpty(), running the value destructors in parallel
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::ParallelMakeEmpty(ForkJoinPool &pool) {
+    if (!is_trivially_destructible<SomeType>::value) {
+        auto destroyData = [](BSTreeNode<SomeType> *treePtr) { treePtr->data.~SomeType(); };
+        ForEachNodeParallel(this->rootPtr, destroyData, pool);
+    }
+
+    this->arena.Clear();
+    this->rootPtr = nullptr;
+}
+
+// Union()
+// Adds every value of other to the tree; where both trees hold equal values, the stored value
+// becomes resolve(mine, theirs), which must compare equal to both and must not throw
+// Subtrees are merged in parallel on pool
+template<typename SomeType, typename Balance>
+template<typename Resolve>
+void BSTree<SomeType, Balance>::Union(const BSTree<SomeType, Balance> &other, Resolve resolve, ForkJoinPool &pool) {
+    if (this == &other) {
+        BSTree<SomeType, Balance> copy(other);
+        Union(copy, resolve, pool);
+        return;
+    }
+
+    // Storage for every value that may be new is taken from the arena up front, so the merge
+    // itself needs no locking; the slots left unused are handed back afterwards
+    vector<void *> slots(other.Size());
+    for (void *&slot : slots)
+        slot = this->arena.Allocate();
+
+    this->rootPtr = UnionWith(this->rootPtr, other.rootPtr, slots.data(), resolve, pool);
+    if (this->rootPtr != nullptr)
+        this->rootPtr->parentPtr = nullptr;
+
+    for (void *slot : slots) {
+        if (slot != nullptr)
+            this->arena.Release(static_cast<BSTreeNode<SomeType> *>(slot));
+    }
+}
+
+// Intersection()
+// Removes every value that is not also in other; each value kept becomes resolve(mine, theirs),
+// which must compare equal to both and must not throw
+// Subtrees are merged in parallel on pool
+template<typename SomeType, typename Balance>
+template<typename Resolve>
+void BSTree<SomeType, Balance>::Intersection(const BSTree<SomeType, Balance> &other, Resolve resolve,
+                                             ForkJoinPool &pool) {
+    if (this == &other) {
+        BSTree<SomeType, Balance> copy(other);
+        Intersection(copy, resolve, pool);
+        return;
+    }
+
+    vector<BSTreeNode<SomeType> *> gaps(other.Size() + 1, nullptr);
+
+    this->rootPtr = IntersectWith(this->rootPtr, other.rootPtr, gaps.data(), resolve, pool);
+    if (this->rootPtr != nullptr)
+        this->rootPtr->parentPtr = nullptr;
+
+    for (BSTreeNode<SomeType> *dropped : gaps)
+        FreeSubtree(dropped);
+}
+
+// Difference()
+// Removes every value that is also in other
+// Subtrees are merged in parallel on pool
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::Difference(const BSTree<SomeType, Balance> &other, ForkJoinPool &pool) {
+    if (this == &other) {
+        MakeEmpty();
+        return;
+    }
+
+    vector<BSTreeNode<SomeType> *> matches(other.Size(), nullptr);
+
+    this->rootPtr = DifferenceWith(this->rootPtr, other.rootPtr, matches.data(), pool);
+    if (this->rootPtr != nullptr)
+        this->rootPtr->parentPtr = nullptr;
+
+    for (BSTreeNode<SomeType> *dropped : matches) {
+        if (dropped != nullptr)
+            FreeNode(dropped);
+    }
 }
 
 // Size()
 // Returns total number of data values stored in tree
-template<typename SomeType>
-int BSTree<SomeType>::Size() const {
-    if (this->rootPtr == nullptr)
-        return 0;
-    else
-        return CountNodes(this->rootPtr);
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::Size() const {
+    return Count(this->rootPtr);
 }
 
 // IsFull()
 // Returns true if BSTree is full; returns false otherwise
-template<typename SomeType>
-bool BSTree<SomeType>::IsFull() const {
+template<typename SomeType, typename Balance>
+bool BSTree<SomeType, Balance>::IsFull() const {
     return false;
 }
 
 // IsEmpty()
 // Returns true if BSTree is empty; returns false otherwise
-template<typename SomeType>
-bool BSTree<SomeType>::IsEmpty() const {
+template<typename SomeType, typename Balance>
+bool BSTree<SomeType, Balance>::IsEmpty() const {
     return rootPtr == nullptr;
 }
 
 // Min()
 // Returns minimum value in tree; throws EmptyBSTree if tree is empty
-template<typename SomeType>
-SomeType BSTree<SomeType>::Min() const {
+template<typename SomeType, typename Balance>
+SomeType BSTree<SomeType, Balance>::Min() const {
     if (this->IsEmpty())
         throw EmptyBSTree();
 
@@ -417,8 +1151,8 @@ SomeType BSTree<SomeType>::Min() const {
 
 // Max()
 // Returns maximum value in tree; throws EmptyBSTree if tree is empty
-template<typename SomeType>
-SomeType BSTree<SomeType>::Max() const {
+template<typename SomeType, typename Balance>
+SomeType BSTree<SomeType, Balance>::Max() const {
     if (this->IsEmpty())
         throw EmptyBSTree();
 
@@ -434,44 +1168,330 @@ SomeType BSTree<SomeType>::Max() const {
 // TotalLevels()
 // Returns the maximum level value for current tree contents
 // Throws EmptyBSTree if empty
-template<typename SomeType>
-int BSTree<SomeType>::TotalLevels() const {
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::TotalLevels() const {
     if (this->IsEmpty())
         throw EmptyBSTree();
 
-    return LevelCount(this->rootPtr);
+    return Height(this->rootPtr);
 }
 
 // Level()
 // Returns the level within the BSTree at which the value item is found
 // If tree is empty, throws EmptyBSTree
 // If tree is not empty and item is not found, throws NotFoundBSTree
-template<typename SomeType>
-int BSTree<SomeType>::Level(SomeType item) const {
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::Level(const SomeType &item) const {
+    int level = 0;
+
+    switch (TryLevel(item, &level)) {
+        case BSTreeStatus::Empty:
+            throw EmptyBSTree();
+        case BSTreeStatus::NotFound:
+            throw NotFoundBSTree();
+        default:
+            return level;
+    }
+}
+
+// TryLevel()
+// Stores the level at which item is found in *level, reporting the outcome instead of throwing
+// Returns Empty if the tree is empty and NotFound if item is not present; *level is then unchanged
+template<typename SomeType, typename Balance>
+BSTreeStatus BSTree<SomeType, Balance>::TryLevel(const SomeType &item, int *level) const {
+    INSTRUMENT_OPERATION(BSTree);
+
+    if (this->IsEmpty())
+        return BSTreeStatus::Empty;
+
+    const BSTreeNode<SomeType> *tmp = this->rootPtr;
+    int depth = 0;
+
+    while (tmp != nullptr) {
+        INSTRUMENT_VISIT(BSTree);
+        if (item < tmp->data) {
+            tmp = tmp->leftPtr;
+        } else if (item > tmp->data) {
+            tmp = tmp->rightPtr;
+        } else {
+            *level = depth;
+            return BSTreeStatus::Ok;
+        }
+        depth++;
+    }
+
+    return BSTreeStatus::NotFound;
+}
+
+// Rank()
+// Returns the number of values in the tree that are smaller than item
+// If item is present this is its zero-based position in sorted order
+template<typename SomeType, typename Balance>
+int BSTree<SomeType, Balance>::Rank(const SomeType &item) const {
+    BSTreeNode<SomeType> *tmp = this->rootPtr;
+    int rank = 0;
+
+    while (tmp != nullptr) {
+        if (item < tmp->data) {
+            tmp = tmp->leftPtr;
+        } else if (item > tmp->data) {
+            rank += Count(tmp->leftPtr) + 1;
+            tmp = tmp->rightPtr;
+        } else {
+            return rank + Count(tmp->leftPtr);
+        }
+    }
+
+    return rank;
+}
+
+// Select()
+// Returns the value at zero-based position k in sorted order
+// If tree is empty, throws EmptyBSTree
+// If k is outside 0..Size()-1, throws NotFoundBSTree
+template<typename SomeType, typename Balance>
+SomeType BSTree<SomeType, Balance>::Select(int k) const {
     if (this->IsEmpty())
         throw EmptyBSTree();
+    if (k < 0 || k >= Count(this->rootPtr))
+        throw NotFoundBSTree();
 
-    return FindLevel(this->rootPtr, item);
+    BSTreeNode<SomeType> *tmp = this->rootPtr;
+
+    while (k != Count(tmp->leftPtr)) {
+        if (k < Count(tmp->leftPtr)) {
+            tmp = tmp->leftPtr;
+        } else {
+            k -= Count(tmp->leftPtr) + 1;
+            tmp = tmp->rightPtr;
+        }
+    }
+
+    return tmp->data;
+}
+
+// Find()
+// Returns a pointer to the stored value equal to item, or nullptr if item is not in the tree
+// Unlike Level(), a miss is not reported by throwing
+template<typename SomeType, typename Balance>
+const SomeType *BSTree<SomeType, Balance>::Find(const SomeType &item) const {
+    INSTRUMENT_OPERATION(BSTree);
+    const BSTreeNode<SomeType> *node = FindNode(item);
+
+    return node == nullptr ? nullptr : &node->data;
+}
+
+// FindMany()
+// Sets out[i] to what Find(keys[i]) would return, for every i
+// Up to FindManyGroup lookups advance together; when one finishes, the next key takes its place
+template<typename SomeType, typename Balance>
+void BSTree<SomeType, Balance>::FindMany(const vector<SomeType> &keys, vector<const SomeType *> &out) const {
+    const BSTreeNode<SomeType> *cursor[FindManyGroup];   // Node each lookup compares against next
+    size_t keyIndex[FindManyGroup];                      // Key each lookup is resolving
+    size_t active = 0;
+    size_t next = 0;
+
+    INSTRUMENT_BATCH(BSTree, keys.size());
+    out.assign(keys.size(), nullptr);
+
+    while (active < FindManyGroup && next < keys.size()) {
+        cursor[active] = this->rootPtr;
+        keyIndex[active++] = next++;
+    }
+
+    while (active > 0) {
+        for (size_t i = 0; i < active; ) {
+            const BSTreeNode<SomeType> *node = cursor[i];
+            const SomeType &key = keys[keyIndex[i]];
+
+            if (node != nullptr)
+                INSTRUMENT_VISIT(BSTree);
+
+            if (node != nullptr && key < node->data) {
+                node = node->leftPtr;
+            } else if (node != nullptr && key > node->data) {
+                node = node->rightPtr;
+            } else {
+                // Lookup finished (out[] already holds nullptr for a miss); start the next key here
+                if (node != nullptr)
+                    out[keyIndex[i]] = &node->data;
+                if (next < keys.size()) {
+                    cursor[i] = this->rootPtr;
+                    keyIndex[i++] = next++;
+                } else {
+                    active--;
+                    cursor[i] = cursor[active];
+                    keyIndex[i] = keyIndex[active];
+                }
+                continue;
+            }
+
+            __builtin_prefetch(node);
+            cursor[i++] = node;
+        }
+    }
+}
+
+// Freeze()
+// Returns a read-only copy of the tree contents in a contiguous Eytzinger layout
+// The BSTree itself is left unchanged
+template<typename SomeType, typename Balance>
+FrozenBSTree<SomeType> BSTree<SomeType, Balance>::Freeze() const {
+    vector<SomeType> sorted;
+
+    sorted.reserve(Size());
+    for (const SomeType &data : *this)
+        sorted.push_back(data);
+
+    return FrozenBSTree<SomeType>(std::move(sorted));
+}
+
+// const_iterator::operator++()
+// Advances to the in-order successor; moves to end() after the maximum value
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator &BSTree<SomeType, Balance>::const_iterator::operator++() {
+    if (nodePtr->rightPtr != nullptr) {
+        // Successor is the leftmost node of the right subtree
+        nodePtr = nodePtr->rightPtr;
+        while (nodePtr->leftPtr != nullptr)
+            nodePtr = nodePtr->leftPtr;
+    } else {
+        // Successor is the first ancestor reached from its left subtree
+        const BSTreeNode<SomeType> *child = nodePtr;
+        nodePtr = nodePtr->parentPtr;
+        while (nodePtr != nullptr && nodePtr->rightPtr == child) {
+            child = nodePtr;
+            nodePtr = nodePtr->parentPtr;
+        }
+    }
+
+    return *this;
+}
+
+// const_iterator::operator--()
+// Steps back to the in-order predecessor; stepping back from end() reaches the maximum value
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator &BSTree<SomeType, Balance>::const_iterator::operator--() {
+    if (nodePtr == nullptr) {
+        nodePtr = tree->rootPtr;
+        while (nodePtr->rightPtr != nullptr)
+            nodePtr = nodePtr->rightPtr;
+    } else if (nodePtr->leftPtr != nullptr) {
+        // Predecessor is the rightmost node of the left subtree
+        nodePtr = nodePtr->leftPtr;
+        while (nodePtr->rightPtr != nullptr)
+            nodePtr = nodePtr->rightPtr;
+    } else {
+        // Predecessor is the first ancestor reached from its right subtree
+        const BSTreeNode<SomeType> *child = nodePtr;
+        nodePtr = nodePtr->parentPtr;
+        while (nodePtr != nullptr && nodePtr->leftPtr == child) {
+            child = nodePtr;
+            nodePtr = nodePtr->parentPtr;
+        }
+    }
+
+    return *this;
+}
+
+// begin()
+// Returns an iterator to the minimum value, or end() if the tree is empty
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator BSTree<SomeType, Balance>::begin() const {
+    const BSTreeNode<SomeType> *tmp = this->rootPtr;
+
+    while (tmp != nullptr && tmp->leftPtr != nullptr)
+        tmp = tmp->leftPtr;
+
+    return const_iterator(tmp, this);
+}
+
+// end()
+// Returns the past-the-end iterator
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator BSTree<SomeType, Balance>::end() const {
+    return const_iterator(nullptr, this);
+}
+
+// LowerBound()
+// Returns an iterator to the first value that is not less than item, or end() if there is none
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator BSTree<SomeType, Balance>::LowerBound(const SomeType &item) const {
+    const BSTreeNode<SomeType> *tmp = this->rootPtr;
+    const BSTreeNode<SomeType> *bound = nullptr;
+
+    while (tmp != nullptr) {
+        if (tmp->data < item) {
+            tmp = tmp->rightPtr;
+        } else {
+            bound = tmp;
+            tmp = tmp->leftPtr;
+        }
+    }
+
+    return const_iterator(bound, this);
+}
+
+// UpperBound()
+// Returns an iterator to the first value that is greater than item, or end() if there is none
+template<typename SomeType, typename Balance>
+typename BSTree<SomeType, Balance>::const_iterator BSTree<SomeType, Balance>::UpperBound(const SomeType &item) const {
+    const BSTreeNode<SomeType> *tmp = this->rootPtr;
+    const BSTreeNode<SomeType> *bound = nullptr;
+
+    while (tmp != nullptr) {
+        if (item < tmp->data) {
+            bound = tmp;
+            tmp = tmp->leftPtr;
+        } else {
+            tmp = tmp->rightPtr;
+        }
+    }
+
+    return const_iterator(bound, this);
+}
+
+// ForEachInRange()
+// Calls visit(value) in ascending order for every value v with lo <= v <= hi
+// Values are passed by const reference; nothing is copied or allocated
+template<typename SomeType, typename Balance>
+template<typename Visit>
+void BSTree<SomeType, Balance>::ForEachInRange(const SomeType &lo, const SomeType &hi, Visit visit) const {
+    for (const_iterator it = LowerBound(lo); it != end() && !(hi < *it); ++it)
+        visit(*it);
 }
 
 // Parent()
 // Returns the value of item's parent from BSTree if item is present AND returns object
 // If tree is empty, throw the EmptyBSTree exception
-// If tree is not empty and item is NOT present, throw NotFoundBSTree
-template<typename SomeType>
-SomeType BSTree<SomeType>::Parent(SomeType item) {
-    if (this->IsEmpty())
-        throw EmptyBSTree();
-
-    // Is this really what it wants me to do?
-    try {
-        SearchForParent(this->rootPtr, item);
-    } catch (BSTreeNode<SomeType>& foundParent) {
-        return foundParent.data;
+// If tree is not empty and item is NOT present (or is the root), throw NotFoundBSTree
+template<typename SomeType, typename Balance>
+SomeType BSTree<SomeType, Balance>::Parent(const SomeType &item) const {
+    const BSTreeNode<SomeType> *parent = nullptr;
+
+    switch (FindParentNode(item, &parent)) {
+        case BSTreeStatus::Empty:
+            throw EmptyBSTree();
+        case BSTreeStatus::Ok:
+            return parent->data;
+        default:
+            throw NotFoundBSTree();
     }
+}
+
+// TryParent()
+// Stores the value of item's parent in *parent, reporting the outcome instead of throwing
+// Returns Empty if the tree is empty, NotFound if item is not present and NoParent if item is
+// the root; *parent is then unchanged
+template<typename SomeType, typename Balance>
+BSTreeStatus BSTree<SomeType, Balance>::TryParent(const SomeType &item, SomeType *parent) const {
+    const BSTreeNode<SomeType> *node = nullptr;
+    BSTreeStatus status = FindParentNode(item, &node);
 
-    throw NotFoundBSTree();
+    if (status == BSTreeStatus::Ok)
+        *parent = node->data;
 
+    return status;
 }
 
 /********  End of Public Interface Functions  *********/
@@ -0,0 +1,788 @@
+//---------------------------------------------------------------
+// File: bstree_bench.cpp
+// Purpose: Benchmarks for the BSTree container loaded with catalog Items.
+//          Usage: BSTree_Bench [itemCount]   (default 1000000)
+// Programming Language: C++
+
+#include "item.h"
+#include "bstree.h"
+#include "frozen_bstree.h"
+#include "catalog_loader.h"
+#include "catalog_image.h"
+#include "price_index.h"
+#include "compact_catalog.h"
+#include "persistent_bstree.h"
+#include "concurrent_bstree.h"
+#include "fork_join.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <malloc.h>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Heap usage through operator new, for the memory figures reported below
+static atomic<long> heapBytes(0);
+static atomic<long> heapAllocations(0);
+
+void *operator new(size_t size) {
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        throw bad_alloc();
+    heapBytes += malloc_usable_size(ptr);
+    heapAllocations++;
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    if (ptr != nullptr)
+        heapBytes -= malloc_usable_size(ptr);
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// The nothrow forms (used by stable_sort's temporary buffer) must pair with the frees above
+void *operator new(size_t size, const nothrow_t &) noexcept {
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        return nullptr;
+    heapBytes += malloc_usable_size(ptr);
+    heapAllocations++;
+    return ptr;
+}
+
+void operator delete(void *ptr, const nothrow_t &) noexcept {
+    operator delete(ptr);
+}
+
+// Seconds elapsed since start
+static double SecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Builds n catalog items with IDs 0..n-1, in ID order or shuffled
+static vector<Item> MakeItems(int n, bool sorted) {
+    mt19937 rng(42);
+    uniform_real_distribution<float> price(0.5f, 100.0f);
+    vector<Item> items;
+
+    items.reserve(n);
+    for (int i = 0; i < n; ++i)
+        items.emplace_back(i, "item" + to_string(i), price(rng));
+
+    if (!sorted)
+        shuffle(items.begin(), items.end(), rng);
+
+    return items;
+}
+
+// Times InsertItem for every item followed by DeleteItem for every other item
+template<typename Balance>
+static void BenchInsertDelete(const char *label, const vector<Item> &items) {
+    BSTree<Item, Balance> tree;
+
+    auto start = chrono::steady_clock::now();
+    for (const Item &item : items)
+        tree.InsertItem(item);
+    double insertSecs = SecondsSince(start);
+    int levels = tree.TotalLevels();
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < items.size(); i += 2)
+        tree.DeleteItem(items[i]);
+    double deleteSecs = SecondsSince(start);
+
+    printf("%-24s n=%-9zu insert %8.3f s   delete(n/2) %8.3f s   levels %d\n",
+           label, items.size(), insertSecs, deleteSecs, levels);
+}
+
+// Times the three insertion paths and counts heap allocations per insert; names are longer than
+// the small-string buffer, so every copied name costs one allocation
+static void BenchInsertPaths(int n) {
+    vector<Item> copySource, moveSource;
+    vector<string> names;
+
+    for (int i = 0; i < n; ++i)
+        names.push_back("catalog-item-name-" + to_string(i));
+    for (int i = 0; i < n; ++i) {
+        copySource.emplace_back(i, names[i], 1.0f);
+        moveSource.emplace_back(i, names[i], 1.0f);
+    }
+
+    auto run = [n](const char *label, auto insert) {
+        BSTree<Item, AVLBalance> tree;
+        long allocations = heapAllocations.load();
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < n; ++i)
+            insert(tree, i);
+        double secs = SecondsSince(start);
+
+        printf("%-24s n=%-9d %8.3f s   %.3f allocations/insert\n",
+               label, n, secs, static_cast<double>(heapAllocations.load() - allocations) / n);
+    };
+
+    run("InsertItem(const &)", [&](BSTree<Item, AVLBalance> &tree, int i) { tree.InsertItem(copySource[i]); });
+    run("InsertItem(&&)", [&](BSTree<Item, AVLBalance> &tree, int i) { tree.InsertItem(std::move(moveSource[i])); });
+    run("EmplaceItem", [&](BSTree<Item, AVLBalance> &tree, int i) { tree.EmplaceItem(i, std::move(names[i]), 1.0f); });
+}
+
+// Times random-key lookups through BSTree::Find and through the frozen Eytzinger copy
+static void BenchLookup(int n) {
+    const int lookups = 1000000;
+    BSTree<Item, AVLBalance> tree;
+    mt19937 rng(7);
+    vector<Item> keys;
+    long found = 0;
+
+    for (const Item &item : MakeItems(n, false))
+        tree.InsertItem(item);
+    FrozenBSTree<Item> frozen = tree.Freeze();
+
+    keys.reserve(lookups);
+    for (int i = 0; i < lookups; ++i)
+        keys.emplace_back(static_cast<int>(rng() % n), "", 0.0f);
+
+    auto start = chrono::steady_clock::now();
+    for (const Item &key : keys)
+        found += tree.Find(key) != nullptr;
+    double treeSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (const Item &key : keys)
+        found += frozen.Find(key) != nullptr;
+    double frozenSecs = SecondsSince(start);
+
+    printf("Lookup n=%-10d BSTree::Find %7.2f Mops/s   FrozenBSTree::Find %7.2f Mops/s   (hits %ld)\n",
+           n, lookups / treeSecs / 1e6, lookups / frozenSecs / 1e6, found);
+}
+
+// Times 10^6 random-key lookups as a loop of BSTree::Find calls and as one FindMany batch,
+// on a tree built by random-order inserts
+static void BenchFindMany(int n) {
+    const int lookups = 1000000;
+    BSTree<Item, AVLBalance> tree;
+    mt19937 rng(5);
+    vector<Item> keys;
+    vector<const Item *> out;
+    long found = 0;
+
+    for (Item &item : MakeItems(n, false))
+        tree.InsertItem(std::move(item));
+
+    keys.reserve(lookups);
+    for (int i = 0; i < lookups; ++i)
+        keys.emplace_back(static_cast<int>(rng() % (2 * n)), "", 0.0f);
+
+    auto start = chrono::steady_clock::now();
+    for (const Item &key : keys)
+        found += tree.Find(key) != nullptr;
+    double loopSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    tree.FindMany(keys, out);
+    double batchSecs = SecondsSince(start);
+    for (const Item *hit : out)
+        found += hit != nullptr;
+
+    printf("FindMany n=%-10d Find loop %7.2f Mops/s   FindMany %7.2f Mops/s   (hits %ld)\n",
+           n, lookups / loopSecs / 1e6, lookups / batchSecs / 1e6, found);
+}
+
+// Times a full in-order scan done three ways: copying into a queue (as Print() used to do),
+// walking const_iterators, and ForEachInRange over the whole key range
+static void BenchScan(int n) {
+    BSTree<Item, AVLBalance> tree;
+    Item probe(n / 2, "", 0.0f);
+    long hits = 0;
+
+    for (const Item &item : MakeItems(n, false))
+        tree.InsertItem(item);
+
+    auto start = chrono::steady_clock::now();
+    queue<Item> inorder;
+    for (const Item &item : tree)
+        inorder.push(item);
+    while (!inorder.empty()) {
+        hits += inorder.front() < probe;
+        inorder.pop();
+    }
+    double queueSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (const Item &item : tree)
+        hits += item < probe;
+    double iterSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    tree.ForEachInRange(tree.Min(), tree.Max(), [&hits, &probe](const Item &item) { hits += item < probe; });
+    double rangeSecs = SecondsSince(start);
+
+    printf("Scan   n=%-10d queue copy %8.3f s   iterator %8.3f s   ForEachInRange %8.3f s   (hits %ld)\n",
+           n, queueSecs, iterSecs, rangeSecs, hits);
+}
+
+// Times Level()/Parent() (which throw on a miss) against TryLevel()/TryParent() for a batch of
+// keys of which hitPercent are present in the tree
+static void BenchTryLookups(int n, int hitPercent) {
+    const int lookups = 200000;
+    BSTree<Item, AVLBalance> tree;
+    mt19937 rng(11);
+    vector<Item> keys;
+    Item parent;
+    long sum = 0;
+    int level = 0;
+
+    for (const Item &item : MakeItems(n, false))
+        tree.InsertItem(item);
+
+    keys.reserve(lookups);
+    for (int i = 0; i < lookups; ++i) {
+        bool hit = static_cast<int>(rng() % 100) < hitPercent;
+        keys.emplace_back(static_cast<int>(rng() % n) + (hit ? 0 : n), "", 0.0f);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (const Item &key : keys) {
+        try {
+            sum += tree.Level(key);
+            tree.Parent(key);
+        } catch (NotFoundBSTree &) {
+            sum--;
+        }
+    }
+    double throwSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (const Item &key : keys) {
+        if (tree.TryLevel(key, &level) == BSTreeStatus::Ok && tree.TryParent(key, &parent) != BSTreeStatus::NotFound)
+            sum += level;
+        else
+            sum--;
+    }
+    double trySecs = SecondsSince(start);
+
+    printf("Level+Parent %3d%% hits   throwing %7.2f Mops/s   Try* %7.2f Mops/s   (checksum %ld)\n",
+           hitPercent, lookups / throwSecs / 1e6, lookups / trySecs / 1e6, sum);
+}
+
+// Times MakeEmpty() on a tree of Items (destructors must run) and on a tree of ints (blocks only),
+// after deleting a third of the items so the arena's free list is in use
+template<typename SomeType>
+static void BenchTeardown(const char *label, const vector<SomeType> &values) {
+    BSTree<SomeType, AVLBalance> tree;
+
+    for (const SomeType &value : values)
+        tree.InsertItem(value);
+    for (size_t i = 0; i < values.size(); i += 3)
+        tree.DeleteItem(values[i]);
+
+    ArenaStats stats = tree.ArenaStatistics();
+
+    auto start = chrono::steady_clock::now();
+    tree.MakeEmpty();
+    double secs = SecondsSince(start);
+
+    printf("MakeEmpty %-6s n=%-9zu %8.3f s   blocks %zu  live %zu  free %zu  fragmentation %.2f\n",
+           label, values.size(), secs, stats.blocks, stats.liveNodes, stats.freeNodes, stats.fragmentation);
+}
+
+// Writes items to a catalog text file, times reading it back with operator>> plus InsertItem,
+// and with LoadCatalog plus BuildFrom on one and on all hardware threads
+static void BenchLoad(const vector<Item> &items) {
+    const string path = "bstree_bench_catalog.txt";
+    int threads = max(1u, thread::hardware_concurrency());
+
+    {
+        ofstream out(path);
+        for (const Item &item : items)
+            out << item.GetID() << " " << item.GetName() << " " << item.GetPrice() << "\n";
+    }
+
+    auto start = chrono::steady_clock::now();
+    {
+        ifstream in(path);
+        BSTree<Item> tree;
+        Item item;
+        while (in >> item)
+            tree.InsertItem(item);
+    }
+    double streamSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    {
+        BSTree<Item, AVLBalance> tree;
+        tree.BuildFrom(LoadCatalog(path));
+    }
+    double loadSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    {
+        BSTree<Item, AVLBalance> tree;
+        tree.BuildFrom(LoadCatalog(path, threads));
+    }
+    double parallelSecs = SecondsSince(start);
+
+    remove(path.c_str());
+    printf("Load   n=%-10zu operator>> + InsertItem %8.3f s   LoadCatalog + BuildFrom %8.3f s   (%d threads) %8.3f s\n",
+           items.size(), streamSecs, loadSecs, threads, parallelSecs);
+}
+
+// Times the query "every item priced $5 to $10" and the 10 cheapest items, answered by full scans
+// of the catalog's BSTree<Item> (copying into a queue, as callers did before, and an iterator
+// walk) and through its price index; each query runs 10 times
+static void BenchPriceIndex(const vector<Item> &items) {
+    const int repeats = 10;
+    PriceIndexedCatalog catalog;
+    long matches = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (const Item &item : items)
+        catalog.InsertItem(item);
+    double buildSecs = SecondsSince(start);
+    const BSTree<Item, AVLBalance> &tree = catalog.Items();
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        queue<Item> inorder;
+        for (const Item &item : tree)
+            inorder.push(item);
+        for (; !inorder.empty(); inorder.pop())
+            matches += inorder.front().GetPrice() >= 5.0f && inorder.front().GetPrice() <= 10.0f;
+    }
+    double queueSecs = SecondsSince(start) / repeats;
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        for (const Item &item : tree)
+            matches += item.GetPrice() >= 5.0f && item.GetPrice() <= 10.0f;
+    }
+    double scanSecs = SecondsSince(start) / repeats;
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        catalog.PriceRange(5.0f, 10.0f, [&matches](const Item &) { matches++; });
+    double indexSecs = SecondsSince(start) / repeats;
+
+    printf("Price  n=%-10zu build index %8.3f s   $5-$10  queue scan %8.4f s   iterator scan %8.4f s   PriceRange %8.4f s\n",
+           items.size(), buildSecs, queueSecs, scanSecs, indexSecs);
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        vector<Item> all(tree.begin(), tree.end());
+        partial_sort(all.begin(), all.begin() + min<size_t>(10, all.size()), all.end(),
+                     [](const Item &a, const Item &b) { return a.GetPrice() < b.GetPrice(); });
+        matches += all.front().GetID() >= 0;
+    }
+    double sortSecs = SecondsSince(start) / repeats;
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        matches += catalog.Cheapest(10).size() + catalog.MostExpensive(10).size();
+    double topSecs = SecondsSince(start) / repeats;
+
+    printf("Price  top-10   scan + partial_sort %8.4f s   Cheapest + MostExpensive %8.6f s   (checksum %ld)\n",
+           sortSecs, topSecs, matches);
+}
+
+// Times merging a delta of n/100 items (half updates of existing IDs, half new IDs) into an n-item
+// tree one element at a time, catching FoundInBSTree to replace existing items, against Union;
+// then removing the delta's IDs with DeleteItem per element against Difference, and Intersection
+static void BenchSetOps(const vector<Item> &items) {
+    int n = static_cast<int>(items.size());
+    int deltaSize = max(1, n / 100);
+    BSTree<Item, AVLBalance> catalog, work, delta;
+    mt19937 rng(13);
+    auto takeTheirs = [](const Item &, const Item &theirs) { return theirs; };
+
+    catalog.BuildFrom(items);
+    for (int i = 0; i < deltaSize; ++i) {
+        int id = i % 2 == 0 ? static_cast<int>(rng() % n) : n + i;
+        try {
+            delta.InsertItem(Item(id, "delta" + to_string(id), 1.0f));
+        } catch (FoundInBSTree &) { }
+    }
+
+    work.ParallelCopy(catalog);
+    auto start = chrono::steady_clock::now();
+    for (const Item &item : delta) {
+        try {
+            work.InsertItem(item);
+        } catch (FoundInBSTree &) {
+            work.DeleteItem(item);
+            work.InsertItem(item);
+        }
+    }
+    double insertSecs = SecondsSince(start);
+    int insertSize = work.Size();
+
+    work.ParallelCopy(catalog);
+    start = chrono::steady_clock::now();
+    work.Union(delta, takeTheirs);
+    double unionSecs = SecondsSince(start);
+
+    printf("Merge  n=%-10d delta %-8d InsertItem loop %8.4f s   Union %8.4f s   (sizes %d %d)\n",
+           n, delta.Size(), insertSecs, unionSecs, insertSize, work.Size());
+
+    work.ParallelCopy(catalog);
+    start = chrono::steady_clock::now();
+    for (const Item &item : delta) {
+        try {
+            work.DeleteItem(item);
+        } catch (NotFoundBSTree &) { }
+    }
+    double deleteSecs = SecondsSince(start);
+    int deleteSize = work.Size();
+
+    work.ParallelCopy(catalog);
+    start = chrono::steady_clock::now();
+    work.Difference(delta);
+    double differenceSecs = SecondsSince(start);
+    int differenceSize = work.Size();
+
+    work.ParallelCopy(catalog);
+    start = chrono::steady_clock::now();
+    work.Intersection(delta, takeTheirs);
+    double intersectionSecs = SecondsSince(start);
+
+    printf("Remove n=%-10d delta %-8d DeleteItem loop %8.4f s   Difference %8.4f s   Intersection %8.4f s   (sizes %d %d %d)\n",
+           n, delta.Size(), deleteSecs, differenceSecs, intersectionSecs, deleteSize, differenceSize, work.Size());
+}
+
+// Compares heap bytes per item and random-lookup latency of BSTree<Item> and CompactCatalog
+// holding the same items; each lookup reads the item's price
+static void BenchCompact(const char *label, const vector<Item> &items) {
+    const int lookups = 1000000;
+    mt19937 rng(17);
+    vector<int> keys;
+    double sum = 0.0;
+
+    keys.reserve(lookups);
+    for (int i = 0; i < lookups; ++i)
+        keys.push_back(static_cast<int>(rng() % items.size()));
+
+    double itemBytes, itemSecs;
+    {
+        long before = heapBytes.load();
+        BSTree<Item, AVLBalance> tree;
+        for (const Item &item : items)
+            tree.InsertItem(item);
+        itemBytes = static_cast<double>(heapBytes.load() - before) / items.size();
+
+        auto start = chrono::steady_clock::now();
+        for (int key : keys) {
+            const Item *item = tree.Find(Item(key, "", 0.0f));
+            sum += item->GetPrice();
+        }
+        itemSecs = SecondsSince(start);
+    }
+
+    double compactBytes, compactSecs;
+    {
+        long before = heapBytes.load();
+        CompactCatalog catalog;
+        for (const Item &item : items)
+            catalog.InsertItem(item);
+        compactBytes = static_cast<double>(heapBytes.load() - before) / items.size();
+
+        CatalogRecord record{};
+        auto start = chrono::steady_clock::now();
+        for (int key : keys) {
+            if (catalog.Find(key, &record))
+                sum += record.price;
+        }
+        compactSecs = SecondsSince(start);
+    }
+
+    printf("Compact %-12s n=%-9zu BSTree<Item> %6.1f bytes/item %7.1f ns/lookup   CompactCatalog %6.1f bytes/item %7.1f ns/lookup   (sum %.0f)\n",
+           label, items.size(), itemBytes, itemSecs / lookups * 1e9, compactBytes, compactSecs / lookups * 1e9, sum);
+}
+
+// Times exporting a tree to a catalog image, opening the image (the startup cost of a service
+// that queries it in place), lookups on the mapping against BSTree::Find, and streaming the
+// image back into a mutable tree
+static void BenchImage(const vector<Item> &items) {
+    const string path = "bstree_bench_catalog.img";
+    const int lookups = 1000000;
+    BSTree<Item, AVLBalance> tree;
+    mt19937 rng(11);
+    vector<int> keys;
+    long found = 0;
+
+    tree.BuildFrom(items);
+    keys.reserve(lookups);
+    for (int i = 0; i < lookups; ++i)
+        keys.push_back(static_cast<int>(rng() % items.size()));
+
+    auto start = chrono::steady_clock::now();
+    WriteCatalogImage(path, tree);
+    double writeSecs = SecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    double openSecs, imageSecs, streamSecs;
+    {
+        CatalogImage image(path);
+        CatalogRecord record;
+        found += image.Find(keys[0], &record);
+        openSecs = SecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        for (int key : keys)
+            found += image.Find(key, &record);
+        imageSecs = SecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        BSTree<Item, AVLBalance> restored;
+        image.StreamInto(restored);
+        streamSecs = SecondsSince(start);
+    }
+
+    start = chrono::steady_clock::now();
+    for (int key : keys)
+        found += tree.Find(Item(key, "", 0.0f)) != nullptr;
+    double treeSecs = SecondsSince(start);
+
+    remove(path.c_str());
+    printf("Image  n=%-10zu write %8.3f s   open+first lookup %8.6f s   StreamInto %8.3f s\n",
+           items.size(), writeSecs, openSecs, streamSecs);
+    printf("Image  lookups  CatalogImage::Find %7.2f Mops/s   BSTree::Find %7.2f Mops/s   (hits %ld)\n",
+           lookups / imageSecs / 1e6, lookups / treeSecs / 1e6, found);
+}
+
+// Takes 1000 snapshots of a persistent tree, applying 100 updates to the live tree after each,
+// and reports snapshot cost and the extra memory all snapshots keep alive; a BSTree deep copy
+// of the same contents is timed for comparison
+static void BenchSnapshots(const vector<Item> &items) {
+    const int snapshots = 1000;
+    const int updatesPerSnapshot = 100;
+    mt19937 rng(5);
+    double snapshotSecs = 0;
+
+    long baseBytes = heapBytes;
+    PersistentBSTree<Item> live;
+    for (const Item &item : items)
+        live.InsertItem(item);
+    long treeBytes = heapBytes - baseBytes;
+
+    vector<PersistentBSTree<Item>> kept;
+    kept.reserve(snapshots);
+    for (int s = 0; s < snapshots; ++s) {
+        auto start = chrono::steady_clock::now();
+        kept.push_back(live);
+        snapshotSecs += SecondsSince(start);
+
+        for (int u = 0; u < updatesPerSnapshot; ++u) {
+            const Item &item = items[rng() % items.size()];
+            live.DeleteItem(item);
+            live.InsertItem(item);
+        }
+    }
+    long keptBytes = heapBytes - baseBytes - treeBytes;
+
+    BSTree<Item, AVLBalance> plain;
+    plain.BuildFrom(items);
+    auto start = chrono::steady_clock::now();
+    BSTree<Item, AVLBalance> deepCopy(plain);
+    double copySecs = SecondsSince(start);
+
+    printf("Snapshot n=%-8zu %.0f ns/snapshot (BSTree copy %.3f s)   tree %.1f MB, %d snapshots x %d updates keep %.1f MB extra\n",
+           items.size(), snapshotSecs / snapshots * 1e9, copySecs, treeBytes / 1e6, snapshots, updatesPerSnapshot,
+           keptBytes / 1e6);
+}
+
+// Runs readers lookup threads against tree for a fixed time while one writer thread replaces a
+// random item every 100 microseconds; returns total lookups per second
+template<typename LookupFn, typename UpdateFn>
+static double ReadThroughput(int readers, const vector<Item> &items, LookupFn lookup, UpdateFn update) {
+    atomic<bool> stop(false);
+    atomic<long> lookups(0);
+    atomic<long> lookupHits(0);
+    vector<thread> threads;
+
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            mt19937 rng(100 + r);
+            long done = 0;
+            long hits = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                hits += lookup(items[rng() % items.size()]);
+                done++;
+            }
+            lookups += done;
+            lookupHits += hits;
+        });
+    }
+    threads.emplace_back([&] {
+        mt19937 rng(99);
+        while (!stop.load(memory_order_relaxed)) {
+            update(items[rng() % items.size()]);
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+    });
+
+    this_thread::sleep_for(chrono::milliseconds(500));
+    stop = true;
+    for (thread &t : threads)
+        t.join();
+
+    if (lookupHits > lookups)
+        printf("unexpected hit count\n");
+
+    return lookups / 0.5;
+}
+
+// Compares read throughput of ConcurrentBSTree with a BSTree behind a reader-writer lock
+static void BenchConcurrentReads(const vector<Item> &items) {
+    int maxReaders = max(4, 2 * static_cast<int>(thread::hardware_concurrency()));
+    BSTree<Item, AVLBalance> locked;
+    ConcurrentBSTree<Item> concurrent;
+    shared_mutex rwLock;
+
+    locked.BuildFrom(items);
+    for (const Item &item : items)
+        concurrent.InsertItem(item);
+
+    for (int readers = 1; readers <= maxReaders; readers *= 2) {
+        double lockedRate = ReadThroughput(readers, items,
+            [&](const Item &key) { shared_lock<shared_mutex> guard(rwLock); return locked.Find(key) != nullptr; },
+            [&](const Item &item) { unique_lock<shared_mutex> guard(rwLock); locked.DeleteItem(item); locked.InsertItem(item); });
+        double concurrentRate = ReadThroughput(readers, items,
+            [&](const Item &key) { Item found; return concurrent.Find(key, &found); },
+            [&](const Item &item) { concurrent.DeleteItem(item); concurrent.InsertItem(item); });
+
+        printf("Readers %-3d BSTree+shared_mutex %7.2f Mlookups/s   ConcurrentBSTree %7.2f Mlookups/s\n",
+               readers, lockedRate / 1e6, concurrentRate / 1e6);
+    }
+}
+
+// Times the Parallel* operations on pools of 1, 2, 4, ... up to the hardware thread count
+static void BenchParallel(const vector<Item> &items) {
+    int maxThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    BSTree<Item, AVLBalance> tree;
+    vector<int> threadCounts;
+
+    tree.BuildFrom(items);
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    for (int threads : threadCounts) {
+        ForkJoinPool pool(threads);
+        BSTree<Item, AVLBalance> copy;
+        atomic<long> cheap(0);
+
+        auto start = chrono::steady_clock::now();
+        double total = tree.ParallelReduce(0.0, [](const Item &item) { return static_cast<double>(item.GetPrice()); },
+                                           [](double a, double b) { return a + b; }, pool);
+        double reduceSecs = SecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        tree.ParallelForEach([&cheap](const Item &item) { if (item.GetPrice() < 5.0f) cheap++; }, pool);
+        double forEachSecs = SecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        copy.ParallelCopy(tree, pool);
+        double copySecs = SecondsSince(start);
+
+        start = chrono::steady_clock::now();
+        copy.ParallelMakeEmpty(pool);
+        double teardownSecs = SecondsSince(start);
+
+        printf("Threads %-3d reduce %7.3f s   for-each %7.3f s   copy %7.3f s   teardown %7.3f s   (sum $%.2f, %ld under $5)\n",
+               threads, reduceSecs, forEachSecs, copySecs, teardownSecs, total, cheap.load());
+    }
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    // Plain BST degenerates into a list on sorted input, so keep that run small
+    int degenerateN = min(n, 10000);
+
+    printf("BSTree<Item> benchmarks\n\n");
+
+    vector<Item> sorted = MakeItems(n, true);
+    vector<Item> random = MakeItems(n, false);
+    vector<Item> sortedSmall = MakeItems(degenerateN, true);
+
+    BenchInsertDelete<NoBalance>("NoBalance sorted", sortedSmall);
+    BenchInsertDelete<NoBalance>("NoBalance random", random);
+    BenchInsertDelete<AVLBalance>("AVLBalance sorted", sorted);
+    BenchInsertDelete<AVLBalance>("AVLBalance random", random);
+    printf("\n");
+
+    BenchInsertPaths(n);
+    printf("\n");
+
+    for (long size = 100000; size <= n && size <= 100000000; size *= 10)
+        BenchLookup(static_cast<int>(size));
+    printf("\n");
+
+    for (long size = 100000; size <= n && size <= 100000000; size *= 10)
+        BenchFindMany(static_cast<int>(size));
+    printf("\n");
+
+    BenchScan(n);
+    printf("\n");
+
+    BenchTryLookups(n, 95);
+    BenchTryLookups(n, 5);
+    printf("\n");
+
+    vector<int> keys(n);
+    for (int i = 0; i < n; ++i)
+        keys[i] = i;
+    shuffle(keys.begin(), keys.end(), mt19937(3));
+    BenchTeardown("Item", random);
+    BenchTeardown("int", keys);
+    printf("\n");
+
+    BenchLoad(random);
+    printf("\n");
+
+    BenchImage(random);
+    printf("\n");
+
+    BenchPriceIndex(random);
+    printf("\n");
+
+    BenchCompact("short names", random);
+    {
+        // Names past the small-string buffer, as real product names are
+        vector<Item> longNames;
+        longNames.reserve(random.size());
+        for (const Item &item : random)
+            longNames.emplace_back(item.GetID(), "catalog-product-" + item.GetName() + "-standard-edition", item.GetPrice());
+        BenchCompact("long names", longNames);
+    }
+    printf("\n");
+
+    BenchSnapshots(random);
+    printf("\n");
+
+    BenchConcurrentReads(random);
+    printf("\n");
+
+    BenchParallel(random);
+    printf("\n");
+
+    BenchSetOps(random);
+
+    // Counters of every run above, when built with CONTAINER_INSTRUMENTATION
+    if (Instrumentation::Enabled()) {
+        printf("\n");
+        fflush(stdout);
+        Instrumentation::WriteJSON(cout);
+    }
+
+    return 0;
+}
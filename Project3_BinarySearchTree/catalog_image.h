@@ -0,0 +1,349 @@
+//
+// catalog_image.h  Memory-mappable binary catalog files
+//
+// NOTES:
+// A catalog image holds the items of a BSTree<Item> in a form that is queried straight from a
+// read-only mapping: opening one maps the file and checks its header, and nothing is parsed or
+// allocated per item.  All sections use native byte order and start on an 8-byte boundary:
+//
+//   CatalogImageHeader                   magic, version, item count and section offsets
+//   int32_t         ids[count + 1]       item IDs in Eytzinger order, slot 0 unused
+//   float           prices[count + 1]    item prices, same slots as ids
+//   CatalogNameRef  names[count + 1]     offset and length of each name in the heap
+//   char            heap[heapSize]       item names, not NUL terminated
+//
+// The ids column is laid out like FrozenBSTree, so a lookup touches one 4-byte slot per level
+// and never reads prices, names or the heap until it has found its slot.
+//
+
+#ifndef CATALOG_IMAGE_H
+#define CATALOG_IMAGE_H
+
+#include "item.h"
+#include "bstree.h"
+#include "catalog_loader.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char CatalogImageMagic[8] = {'B', 'S', 'T', 'C', 'A', 'T', 'L', 'G'};
+static const uint32_t CatalogImageVersion = 1;
+static const uint32_t CatalogImageByteOrder = 0x01020304;   // Reads back differently on a foreign-endian machine
+
+// Fixed-size header at the start of every catalog image
+struct CatalogImageHeader {
+    char magic[8];                       // CatalogImageMagic
+    uint32_t version;                    // CatalogImageVersion
+    uint32_t byteOrder;                  // CatalogImageByteOrder as written by the exporting machine
+    uint64_t count;                      // Number of items
+    uint64_t idsOffset;                  // File offset of the ids column
+    uint64_t pricesOffset;               // File offset of the prices column
+    uint64_t namesOffset;                // File offset of the name references
+    uint64_t heapOffset;                 // File offset of the name heap
+    uint64_t heapSize;                   // Bytes in the name heap
+};
+
+static_assert(sizeof(CatalogImageHeader) == 64, "catalog image header must stay 64 bytes");
+
+// Location of one item name inside the heap
+struct CatalogNameRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// One item as seen through a mapped image; name points into the mapping
+struct CatalogRecord {
+    int id;
+    string_view name;
+    float price;
+};
+
+// CatalogImageFirstSlot()
+// Returns the Eytzinger slot of the smallest of count values, or 0 if count is 0
+inline size_t CatalogImageFirstSlot(size_t count) {
+    size_t k = 1;
+
+    if (count == 0)
+        return 0;
+
+    while (2 * k <= count)
+        k = 2 * k;
+
+    return k;
+}
+
+// CatalogImageNextSlot()
+// Returns the Eytzinger slot of the in-order successor of slot k, or 0 after the largest value
+inline size_t CatalogImageNextSlot(size_t k, size_t count) {
+    if (2 * k + 1 <= count) {
+        // Successor is the leftmost slot of the right subtree
+        k = 2 * k + 1;
+        while (2 * k <= count)
+            k = 2 * k;
+        return k;
+    }
+
+    // Successor is the first ancestor reached from its left subtree
+    while (k & 1)
+        k >>= 1;
+    return k >> 1;
+}
+
+class CatalogImage {                   // Read-only catalog queried in place from a mapped file
+private:
+    void *mapping;                       // Start of the mapped file
+    size_t length;                       // Bytes mapped
+    size_t count;                        // Number of items
+    const int32_t *ids;                  // Eytzinger ordered IDs, ids[0] unused
+    const float *prices;                 // Prices, same slots as ids
+    const CatalogNameRef *names;         // Name references, same slots as ids
+    const char *heap;                    // Name bytes
+    uint64_t heapSize;                   // Bytes in heap
+
+    size_t FindSlot(int itemID) const;
+    CatalogRecord Record(size_t k) const;
+
+public:
+    explicit CatalogImage(const string &path);
+    CatalogImage(const CatalogImage &) = delete;
+    CatalogImage &operator=(const CatalogImage &) = delete;
+    ~CatalogImage();
+    int Size() const;
+    bool IsEmpty() const;
+    bool Find(int itemID, CatalogRecord *record) const;
+    template<typename Visit>
+    void ForEach(Visit visit) const;
+    template<typename Balance>
+    void StreamInto(BSTree<Item, Balance> &tree) const;
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// FindSlot()
+// Returns the slot holding itemID, or 0 if no item has that ID
+inline size_t CatalogImage::FindSlot(int itemID) const {
+    const int32_t *base = this->ids;
+    size_t k = 1;
+
+    while (k <= this->count) {
+        // Prefetch four levels ahead, but only while that slot is still inside the ids column
+        size_t ahead = k * 16;
+        if (ahead <= this->count)
+            __builtin_prefetch(base + ahead);
+        k = 2 * k + (base[k] < itemID);
+    }
+
+    // k went right on every compare since the last left turn; undo those steps and the left turn
+    k >>= __builtin_ffsll(~k);
+
+    if (k == 0 || itemID < base[k])
+        return 0;
+
+    return k;
+}
+
+// Record()
+// Returns a view of the item in slot k
+// Throws CatalogFormatError if the slot's name lies outside the heap
+inline CatalogRecord CatalogImage::Record(size_t k) const {
+    CatalogNameRef ref = this->names[k];
+
+    if (static_cast<uint64_t>(ref.offset) + ref.length > this->heapSize)
+        throw CatalogFormatError();
+
+    return {this->ids[k], string_view(this->heap + ref.offset, ref.length), this->prices[k]};
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// CatalogImage()
+// Maps the catalog image at path and checks its header and section bounds
+// Throws CatalogFileError if the file cannot be opened or mapped and CatalogFormatError if it
+// is not a version 1 image written with this machine's byte order
+inline CatalogImage::CatalogImage(const string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw CatalogFileError();
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw CatalogFileError();
+    }
+
+    this->length = static_cast<size_t>(info.st_size);
+    if (this->length < sizeof(CatalogImageHeader)) {
+        close(fd);
+        throw CatalogFormatError();
+    }
+
+    this->mapping = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (this->mapping == MAP_FAILED)
+        throw CatalogFileError();
+
+    const char *file = static_cast<const char *>(this->mapping);
+    const CatalogImageHeader *header = reinterpret_cast<const CatalogImageHeader *>(file);
+    uint64_t slots = header->count + 1;
+
+    // Each section must be aligned and lie inside the file; checked so no sum can overflow
+    auto fits = [this](uint64_t offset, uint64_t bytes, uint64_t align) {
+        return offset % align == 0 && offset <= this->length && bytes <= this->length - offset;
+    };
+
+    if (memcmp(header->magic, CatalogImageMagic, sizeof(CatalogImageMagic)) != 0 ||
+        header->version != CatalogImageVersion || header->byteOrder != CatalogImageByteOrder ||
+        header->count >= this->length ||
+        !fits(header->idsOffset, slots * sizeof(int32_t), alignof(int32_t)) ||
+        !fits(header->pricesOffset, slots * sizeof(float), alignof(float)) ||
+        !fits(header->namesOffset, slots * sizeof(CatalogNameRef), alignof(CatalogNameRef)) ||
+        !fits(header->heapOffset, header->heapSize, 1)) {
+        munmap(this->mapping, this->length);
+        throw CatalogFormatError();
+    }
+
+    this->count = static_cast<size_t>(header->count);
+    this->ids = reinterpret_cast<const int32_t *>(file + header->idsOffset);
+    this->prices = reinterpret_cast<const float *>(file + header->pricesOffset);
+    this->names = reinterpret_cast<const CatalogNameRef *>(file + header->namesOffset);
+    this->heap = file + header->heapOffset;
+    this->heapSize = header->heapSize;
+}
+
+// ~CatalogImage()
+// Unmaps the file; records and names obtained from the image must not be used afterwards
+inline CatalogImage::~CatalogImage() {
+    munmap(this->mapping, this->length);
+}
+
+// Size()
+// Returns the number of items in the image
+inline int CatalogImage::Size() const {
+    return static_cast<int>(this->count);
+}
+
+// IsEmpty()
+// Returns true if the image holds no items; returns false otherwise
+inline bool CatalogImage::IsEmpty() const {
+    return this->count == 0;
+}
+
+// Find()
+// Fills *record with the item whose ID is itemID and returns true, or returns false if there
+// is no such item; record->name points into the mapping
+inline bool CatalogImage::Find(int itemID, CatalogRecord *record) const {
+    size_t k = FindSlot(itemID);
+
+    if (k == 0)
+        return false;
+
+    *record = Record(k);
+    return true;
+}
+
+// ForEach()
+// Calls visit(record) for every item in ascending ID order
+template<typename Visit>
+void CatalogImage::ForEach(Visit visit) const {
+    for (size_t k = CatalogImageFirstSlot(this->count); k != 0; k = CatalogImageNextSlot(k, this->count))
+        visit(Record(k));
+}
+
+// StreamInto()
+// Replaces the contents of tree with the items of the image
+// Items come out in ID order, so BuildFrom takes its O(n) path: it still checks the order and
+// drops duplicate IDs (the image's order is not validated when it is opened), but never sorts
+template<typename Balance>
+void CatalogImage::StreamInto(BSTree<Item, Balance> &tree) const {
+    vector<Item> items;
+
+    items.reserve(this->count);
+    ForEach([&items](const CatalogRecord &record) {
+        items.emplace_back(record.id, string(record.name), record.price);
+    });
+
+    tree.BuildFrom(std::move(items));
+}
+
+// WriteCatalogImage()
+// Writes the items of tree to a catalog image at path, replacing any existing file atomically
+// Throws CatalogFileError if the file cannot be written and CatalogFormatError if the names
+// total 4 GiB or more
+template<typename Balance>
+void WriteCatalogImage(const string &path, const BSTree<Item, Balance> &tree) {
+    size_t count = static_cast<size_t>(tree.Size());
+    vector<int32_t> ids(count + 1, 0);
+    vector<float> prices(count + 1, 0.0f);
+    vector<CatalogNameRef> names(count + 1, CatalogNameRef{0, 0});
+    string heap;
+    size_t k = CatalogImageFirstSlot(count);
+
+    for (const Item &item : tree) {
+        const string &name = item.GetName();
+
+        if (heap.size() + name.size() > UINT32_MAX)
+            throw CatalogFormatError();
+
+        ids[k] = item.GetID();
+        prices[k] = item.GetPrice();
+        names[k] = {static_cast<uint32_t>(heap.size()), static_cast<uint32_t>(name.size())};
+        heap += name;
+        k = CatalogImageNextSlot(k, count);
+    }
+
+    auto aligned = [](uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); };
+
+    CatalogImageHeader header;
+    memcpy(header.magic, CatalogImageMagic, sizeof(CatalogImageMagic));
+    header.version = CatalogImageVersion;
+    header.byteOrder = CatalogImageByteOrder;
+    header.count = count;
+    header.idsOffset = sizeof(CatalogImageHeader);
+    header.pricesOffset = aligned(header.idsOffset + ids.size() * sizeof(int32_t));
+    header.namesOffset = aligned(header.pricesOffset + prices.size() * sizeof(float));
+    header.heapOffset = aligned(header.namesOffset + names.size() * sizeof(CatalogNameRef));
+    header.heapSize = heap.size();
+
+    // Sections are written in file order, each padded with zeros up to the next section's offset
+    const string tmpPath = path + ".tmp";
+    FILE *out = fopen(tmpPath.c_str(), "wb");
+    if (out == nullptr)
+        throw CatalogFileError();
+
+    const char padding[8] = {0};
+    uint64_t written = 0;
+    bool ok = true;
+    auto put = [&](const void *data, uint64_t bytes, uint64_t nextOffset) {
+        ok = ok && fwrite(data, 1, bytes, out) == bytes;
+        written += bytes;
+        ok = ok && fwrite(padding, 1, nextOffset - written, out) == nextOffset - written;
+        written = nextOffset;
+    };
+
+    put(&header, sizeof(header), header.idsOffset);
+    put(ids.data(), ids.size() * sizeof(int32_t), header.pricesOffset);
+    put(prices.data(), prices.size() * sizeof(float), header.namesOffset);
+    put(names.data(), names.size() * sizeof(CatalogNameRef), header.heapOffset);
+    put(heap.data(), heap.size(), header.heapOffset + heap.size());
+
+    if (fclose(out) != 0 || !ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        throw CatalogFileError();
+    }
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
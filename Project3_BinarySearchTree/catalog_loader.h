@@ -0,0 +1,158 @@
+//
+// catalog_loader.h  Fast loader for catalog text files
+//
+// NOTES:
+// A catalog file holds one item per line as "id name price", the same fields Item's operator>>
+// reads.  The file is memory-mapped and parsed in place with from_chars, which avoids iostream
+// and locale overhead.  With threads > 1 the file is cut into chunks at line boundaries and
+// each chunk is parsed on its own thread; items come back in file order either way.
+//
+
+#ifndef CATALOG_LOADER_H
+#define CATALOG_LOADER_H
+
+#include "item.h"
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Exception classes
+class CatalogFileError: public std::exception { };      // Exception class models an unreadable catalog file
+class CatalogFormatError: public std::exception { };    // Exception class models a malformed catalog line
+
+// IsCatalogSpace()
+// Returns true for the whitespace characters that separate catalog fields and lines
+inline bool IsCatalogSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// ParseCatalogChunk()
+// Parses every "id name price" record in [first, last) and appends the items to out
+// Throws CatalogFormatError if a record is incomplete or a number does not parse
+inline void ParseCatalogChunk(const char *first, const char *last, vector<Item> &out) {
+    const char *pos = first;
+
+    while (true) {
+        while (pos < last && IsCatalogSpace(*pos))
+            pos++;
+        if (pos == last)
+            return;
+
+        int id;
+        from_chars_result idEnd = from_chars(pos, last, id);
+        if (idEnd.ec != errc())
+            throw CatalogFormatError();
+
+        pos = idEnd.ptr;
+        while (pos < last && IsCatalogSpace(*pos))
+            pos++;
+        const char *nameStart = pos;
+        while (pos < last && !IsCatalogSpace(*pos))
+            pos++;
+        if (pos == nameStart)
+            throw CatalogFormatError();
+        string name(nameStart, pos);
+
+        while (pos < last && IsCatalogSpace(*pos))
+            pos++;
+        float price;
+        from_chars_result priceEnd = from_chars(pos, last, price);
+        if (priceEnd.ec != errc())
+            throw CatalogFormatError();
+
+        pos = priceEnd.ptr;
+        out.emplace_back(id, std::move(name), price);
+    }
+}
+
+// LoadCatalog()
+// Reads every item from the catalog file at path, in file order, using up to threads parser threads
+// Throws CatalogFileError if the file cannot be opened or mapped and CatalogFormatError on a bad record
+inline vector<Item> LoadCatalog(const string &path, int threads = 1) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw CatalogFileError();
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw CatalogFileError();
+    }
+
+    size_t length = static_cast<size_t>(info.st_size);
+    vector<Item> items;
+    if (length == 0) {
+        close(fd);
+        return items;
+    }
+
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw CatalogFileError();
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    const char *text = static_cast<const char *>(mapping);
+    const char *textEnd = text + length;
+
+    // Chunk boundaries are moved forward to the next line start so no record is split
+    size_t chunks = threads < 1 ? 1 : static_cast<size_t>(threads);
+    vector<const char *> bounds(1, text);
+    for (size_t i = 1; i < chunks; ++i) {
+        const char *cut = max(bounds.back(), text + length * i / chunks);
+        while (cut < textEnd && *cut != '\n')
+            cut++;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(textEnd);
+
+    vector<vector<Item>> parsed(chunks);
+    vector<exception_ptr> errors(chunks);
+    vector<thread> workers;
+
+    for (size_t i = 1; i < chunks; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                ParseCatalogChunk(bounds[i], bounds[i + 1], parsed[i]);
+            } catch (...) {
+                errors[i] = current_exception();
+            }
+        });
+    }
+    try {
+        ParseCatalogChunk(bounds[0], bounds[1], chunks == 1 ? items : parsed[0]);
+    } catch (...) {
+        errors[0] = current_exception();
+    }
+    for (thread &worker : workers)
+        worker.join();
+
+    munmap(mapping, length);
+    for (exception_ptr &error : errors) {
+        if (error)
+            rethrow_exception(error);
+    }
+
+    if (chunks > 1) {
+        size_t total = 0;
+        for (vector<Item> &part : parsed)
+            total += part.size();
+        items.reserve(total);
+        for (vector<Item> &part : parsed)
+            items.insert(items.end(), make_move_iterator(part.begin()), make_move_iterator(part.end()));
+    }
+
+    return items;
+}
+
+#endif
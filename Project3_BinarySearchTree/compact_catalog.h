@@ -0,0 +1,324 @@
+//
+// compact_catalog.h  Catalog of Items with small tree nodes
+//
+// NOTES:
+// A BSTreeNode<Item> carries the whole Item (ID, price and a std::string) although a descent
+// only compares IDs.  CompactCatalog splits each item three ways:
+//
+//   - the tree node holds only the ID and a 32-bit payload handle (40-byte nodes on 64-bit)
+//   - the payload table, one contiguous vector, holds the price and a 32-bit name handle
+//   - the names live once each in a StringArena; equal names share one copy
+//
+// StringArena packs strings into 64 KiB blocks that never move, so a handle is just a block
+// number and an offset (16 bits each) and the views it hands out stay valid as it grows.
+//
+// A lookup therefore walks nodes half the size of BSTreeNode<Item> and touches the payload and
+// the name only once, at the end.  Payload slots of deleted items are reused; interned names are
+// kept until MakeEmpty(), since other items may share them.
+//
+
+#ifndef COMPACT_CATALOG_H
+#define COMPACT_CATALOG_H
+
+#include "item.h"
+#include "bstree.h"
+#include "catalog_image.h"
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Exception classes
+class StringArenaFullError: public std::exception { };   // Exception class models a StringArena past 4 GiB
+
+class StringArena {                    // Interning store for strings, addressed by 32-bit handles
+private:
+    static constexpr uint32_t EmptySlot = UINT32_MAX;
+    static constexpr size_t BlockBytes = 65536;     // Size of a block and the limit of a handle's offset
+    static constexpr size_t MaxBlocks = 65535;      // Keeps every handle below EmptySlot
+
+    vector<unique_ptr<char[]>> blocks;   // Each string as a 4-byte length followed by its bytes
+    size_t used;                         // Bytes filled in the newest block
+    size_t bytes;                        // Bytes held by all blocks
+    vector<uint32_t> table;              // Open-addressing hash table of handles, EmptySlot if unused
+    size_t count;                        // Distinct strings stored
+
+    void Grow();
+
+public:
+    StringArena();
+    uint32_t Intern(string_view text);
+    string_view Get(uint32_t handle) const;
+    size_t Size() const;
+    size_t Bytes() const;
+    void Clear();
+};
+
+// Key stored in a CompactCatalog node: the item ID and the index of its payload
+struct CompactCatalogKey {
+    int id;
+    uint32_t payload;
+};
+
+// Overloaded LESS THAN operator
+// Returns true if leftop.id < rightop.id; the payload handle is not compared
+inline bool operator<(const CompactCatalogKey &leftop, const CompactCatalogKey &rightop) {
+    return leftop.id < rightop.id;
+}
+
+// Overloaded GREATER THAN operator
+// Returns true if leftop.id > rightop.id; the payload handle is not compared
+inline bool operator>(const CompactCatalogKey &leftop, const CompactCatalogKey &rightop) {
+    return leftop.id > rightop.id;
+}
+
+class CompactCatalog {                 // Item catalog with key-only tree nodes
+private:
+    struct Payload {                     // Non-key attributes of one item
+        float price;
+        uint32_t name;                   // StringArena handle
+    };
+
+    BSTree<CompactCatalogKey, AVLBalance> keys;
+    vector<Payload> payloads;            // Indexed by CompactCatalogKey::payload
+    vector<uint32_t> freePayloads;       // Payload slots of deleted items
+    StringArena names;
+
+    CatalogRecord Record(const CompactCatalogKey &key) const;
+
+public:
+    void InsertItem(const Item &item);
+    void InsertItem(int itemID, string_view name, float price);
+    Item DeleteItem(int itemID);
+    void MakeEmpty();
+    int Size() const;
+    bool IsEmpty() const;
+    bool Find(int itemID, CatalogRecord *record) const;
+    template<typename Visit>
+    void ForEach(Visit visit) const;
+};
+
+/********  Start of StringArena Functions  *********/
+
+// StringArena()
+// Creates an empty arena
+inline StringArena::StringArena() {
+    Clear();
+}
+
+// Grow()
+// Doubles the hash table and reinserts every handle
+inline void StringArena::Grow() {
+    vector<uint32_t> old(2 * this->table.size(), EmptySlot);
+    size_t mask = old.size() - 1;
+
+    old.swap(this->table);
+    for (uint32_t handle : old) {
+        if (handle == EmptySlot)
+            continue;
+
+        size_t slot = hash<string_view>()(Get(handle)) & mask;
+        while (this->table[slot] != EmptySlot)
+            slot = (slot + 1) & mask;
+        this->table[slot] = handle;
+    }
+}
+
+// Intern()
+// Returns the handle of the stored copy of text, adding a copy if text is not stored yet
+// Throws StringArenaFullError if the arena would grow past 4 GiB
+inline uint32_t StringArena::Intern(string_view text) {
+    size_t mask = this->table.size() - 1;
+    size_t slot = hash<string_view>()(text) & mask;
+
+    for (; this->table[slot] != EmptySlot; slot = (slot + 1) & mask) {
+        if (Get(this->table[slot]) == text)
+            return this->table[slot];
+    }
+
+    // A string that does not fit in the newest block starts a new one; one longer than a block
+    // gets a block of its own
+    size_t need = sizeof(uint32_t) + text.size();
+    if (this->blocks.empty() || this->used + need > BlockBytes) {
+        if (this->blocks.size() == MaxBlocks || text.size() > UINT32_MAX)
+            throw StringArenaFullError();
+        this->blocks.emplace_back(new char[max(need, BlockBytes)]);
+        this->bytes += max(need, BlockBytes);
+        this->used = 0;
+    }
+
+    uint32_t handle = static_cast<uint32_t>((this->blocks.size() - 1) * BlockBytes + this->used);
+    uint32_t length = static_cast<uint32_t>(text.size());
+    char *dest = this->blocks.back().get() + this->used;
+
+    memcpy(dest, &length, sizeof(length));
+    memcpy(dest + sizeof(length), text.data(), text.size());
+    this->used += need;
+    this->table[slot] = handle;
+
+    // Keep the table at most three quarters full so probe sequences stay short
+    if (++this->count * 4 > this->table.size() * 3)
+        Grow();
+
+    return handle;
+}
+
+// Get()
+// Returns the string stored under handle; the view is valid until Clear()
+inline string_view StringArena::Get(uint32_t handle) const {
+    const char *stored = this->blocks[handle / BlockBytes].get() + handle % BlockBytes;
+    uint32_t length;
+
+    memcpy(&length, stored, sizeof(length));
+    return string_view(stored + sizeof(length), length);
+}
+
+// Size()
+// Returns the number of distinct strings stored
+inline size_t StringArena::Size() const {
+    return this->count;
+}
+
+// Bytes()
+// Returns the bytes held by the arena's blocks
+inline size_t StringArena::Bytes() const {
+    return this->bytes;
+}
+
+// Clear()
+// Removes every string; all handles become invalid
+inline void StringArena::Clear() {
+    this->blocks.clear();
+    this->used = 0;
+    this->bytes = 0;
+    this->table.assign(16, EmptySlot);
+    this->count = 0;
+}
+
+/********  End of StringArena Functions  *********/
+
+
+/********  Start of Private Interface Functions  *********/
+
+// Record()
+// Returns a view of the item whose node holds key
+inline CatalogRecord CompactCatalog::Record(const CompactCatalogKey &key) const {
+    const Payload &payload = this->payloads[key.payload];
+
+    return {key.id, this->names.Get(payload.name), payload.price};
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// InsertItem()
+// Inserts item into the catalog
+// If an item with the same ID is already present, throws FoundInBSTree
+// If the arena has no room for the name, throws StringArenaFullError and changes nothing
+inline void CompactCatalog::InsertItem(const Item &item) {
+    InsertItem(item.GetID(), item.GetName(), item.GetPrice());
+}
+
+// InsertItem()
+// Same as above, taking the item's attributes separately
+inline void CompactCatalog::InsertItem(int itemID, string_view name, float price) {
+    uint32_t slot;
+
+    if (this->freePayloads.empty()) {
+        slot = static_cast<uint32_t>(this->payloads.size());
+        this->payloads.push_back(Payload{price, 0});
+    } else {
+        slot = this->freePayloads.back();
+        this->freePayloads.pop_back();
+    }
+
+    try {
+        this->keys.InsertItem(CompactCatalogKey{itemID, slot});
+    } catch (...) {
+        this->freePayloads.push_back(slot);
+        throw;
+    }
+
+    // Interned only once the ID is known to be new, so a rejected insert leaves no name behind
+    try {
+        this->payloads[slot] = Payload{price, this->names.Intern(name)};
+    } catch (...) {
+        this->keys.DeleteItem(CompactCatalogKey{itemID, slot});
+        this->freePayloads.push_back(slot);
+        throw;
+    }
+}
+
+// DeleteItem()
+// Deletes the item with ID itemID from the catalog AND returns it
+// If the catalog is empty, throw the EmptyBSTree exception
+// If it is not empty and no item has that ID, throw NotFoundBSTree
+inline Item CompactCatalog::DeleteItem(int itemID) {
+    CompactCatalogKey probe{itemID, 0};
+    const CompactCatalogKey *key = this->keys.Find(probe);
+
+    if (key == nullptr)
+        this->keys.DeleteItem(probe);            // Throws EmptyBSTree or NotFoundBSTree
+
+    CatalogRecord record = Record(*key);
+    Item removed(record.id, string(record.name), record.price);
+
+    this->freePayloads.push_back(key->payload);
+    this->keys.DeleteItem(probe);
+
+    return removed;
+}
+
+// MakeEmpty()
+// Deletes every item and every interned name
+inline void CompactCatalog::MakeEmpty() {
+    this->keys.MakeEmpty();
+    this->payloads.clear();
+    this->freePayloads.clear();
+    this->names.Clear();
+}
+
+// Size()
+// Returns the number of items in the catalog
+inline int CompactCatalog::Size() const {
+    return this->keys.Size();
+}
+
+// IsEmpty()
+// Returns true if the catalog holds no items; returns false otherwise
+inline bool CompactCatalog::IsEmpty() const {
+    return this->keys.IsEmpty();
+}
+
+// Find()
+// Fills *record with the item whose ID is itemID and returns true, or returns false if there is
+// no such item; record->name stays valid until MakeEmpty()
+inline bool CompactCatalog::Find(int itemID, CatalogRecord *record) const {
+    const CompactCatalogKey *key = this->keys.Find(CompactCatalogKey{itemID, 0});
+
+    if (key == nullptr)
+        return false;
+
+    *record = Record(*key);
+    return true;
+}
+
+// ForEach()
+// Calls visit(record) for every item in ascending ID order
+template<typename Visit>
+void CompactCatalog::ForEach(Visit visit) const {
+    for (const CompactCatalogKey &key : this->keys)
+        visit(Record(key));
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
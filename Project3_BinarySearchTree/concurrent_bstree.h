@@ -0,0 +1,387 @@
+//
+// concurrent_bstree.h  AVL Binary Search Tree with lock-free readers and serialized writers
+//
+// NOTES:
+// ConcurrentBSTree stores the same immutable nodes as PersistentBSTree.  A writer takes the write
+// lock, builds the new version by path copying, and publishes it with a single release store of
+// the root pointer.  Readers load the root with acquire and then walk nodes that never change, so
+// Min, Max, Level, Find and ForEach never block and never see a half-applied update.
+//
+// Nodes dropped from the current version are not freed at once, since a reader may still be
+// walking them.  EpochReclaim retires them with the global epoch at the time of removal and frees
+// them once every reader that was active in that epoch has left its read-side critical section.
+//
+
+#ifndef CONCURRENT_BSTREE_H
+#define CONCURRENT_BSTREE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "persistent_bstree.h"
+
+using namespace std;
+
+// Epoch-based reclamation shared by every ConcurrentBSTree
+class EpochReclaim {
+private:
+    struct ReaderSlot {                  // Per-thread reader state, reused after the thread exits
+        atomic<uint64_t> epoch;          // Epoch observed on entry, 0 while not reading
+        atomic<bool> inUse;              // Slot is owned by a live thread
+        int depth;                       // Nesting depth of ReadGuards on the owning thread
+    };
+
+    struct Retired {                     // Node waiting for readers to leave its epoch
+        const void *node;
+        void (*destroy)(const void *);
+        uint64_t epoch;
+    };
+
+    struct Domain {
+        atomic<uint64_t> globalEpoch{1};
+        mutex lock;                      // Guards readers and retired
+        vector<ReaderSlot *> readers;
+        vector<Retired> retired;
+
+        ~Domain() {
+            for (Retired &r : retired)
+                r.destroy(r.node);
+            for (ReaderSlot *slot : readers)
+                delete slot;
+        }
+    };
+
+    struct SlotOwner {                   // Returns the thread's slot to the pool when the thread exits
+        ReaderSlot *slot = nullptr;
+        ~SlotOwner() {
+            if (slot != nullptr)
+                slot->inUse.store(false, memory_order_release);
+        }
+    };
+
+    static Domain &GetDomain() {
+        static Domain domain;
+        return domain;
+    }
+
+    // LocalSlot()
+    // Returns this thread's reader slot, claiming a free one (or adding one) on first use
+    static ReaderSlot *LocalSlot() {
+        thread_local SlotOwner owner;
+
+        if (owner.slot == nullptr) {
+            Domain &domain = GetDomain();
+            lock_guard<mutex> guard(domain.lock);
+
+            for (ReaderSlot *slot : domain.readers) {
+                bool expected = false;
+                if (slot->inUse.compare_exchange_strong(expected, true)) {
+                    owner.slot = slot;
+                    break;
+                }
+            }
+            if (owner.slot == nullptr) {
+                owner.slot = new ReaderSlot{{0}, {true}, 0};
+                domain.readers.push_back(owner.slot);
+            }
+        }
+
+        return owner.slot;
+    }
+
+public:
+    // Marks the calling thread as reading for the guard's lifetime; guards may nest
+    class ReadGuard {
+    private:
+        ReaderSlot *slot;
+
+    public:
+        ReadGuard() : slot(LocalSlot()) {
+            if (slot->depth++ == 0) {
+                slot->epoch.store(GetDomain().globalEpoch.load(), memory_order_relaxed);
+                atomic_thread_fence(memory_order_seq_cst);
+            }
+        }
+
+        ~ReadGuard() {
+            if (--slot->depth == 0)
+                slot->epoch.store(0, memory_order_release);
+        }
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+    };
+
+    // Retire()
+    // Queues an unlinked node to be deleted once no reader can still reach it
+    template<typename NodeType>
+    static void Retire(const NodeType *node) {
+        Domain &domain = GetDomain();
+        lock_guard<mutex> guard(domain.lock);
+
+        domain.retired.push_back({node, [](const void *p) { delete static_cast<const NodeType *>(p); },
+                                  domain.globalEpoch.load()});
+    }
+
+    // Collect()
+    // Advances the global epoch and deletes every retired node older than all active readers
+    // Called by writers after they publish a new root and retire the nodes it replaced
+    static void Collect() {
+        Domain &domain = GetDomain();
+        vector<Retired> ready;
+
+        domain.globalEpoch.fetch_add(1);
+        atomic_thread_fence(memory_order_seq_cst);
+        {
+            lock_guard<mutex> guard(domain.lock);
+            uint64_t oldestActive = UINT64_MAX;
+
+            for (ReaderSlot *slot : domain.readers) {
+                uint64_t epoch = slot->epoch.load(memory_order_acquire);
+                if (epoch != 0 && epoch < oldestActive)
+                    oldestActive = epoch;
+            }
+
+            auto keep = partition(domain.retired.begin(), domain.retired.end(),
+                                  [oldestActive](const Retired &r) { return r.epoch >= oldestActive; });
+            ready.assign(keep, domain.retired.end());
+            domain.retired.erase(keep, domain.retired.end());
+        }
+
+        for (Retired &r : ready)
+            r.destroy(r.node);
+    }
+};
+
+template<typename SomeType>
+class ConcurrentBSTree {               // Concurrent BSTree Abstract Data Type
+private:
+    typedef PersistentBSTree<SomeType, EpochReclaim> Versions;
+    typedef PersistentBSTreeNode<SomeType> Node;
+
+    atomic<const Node *> rootPtr;        // Root of the current version, published with release
+    mutex writeLock;                     // Serializes InsertItem, DeleteItem and MakeEmpty
+    void Publish(const Node *newRoot);
+
+public:
+    ConcurrentBSTree();
+    ConcurrentBSTree(const ConcurrentBSTree<SomeType> &) = delete;
+    ConcurrentBSTree<SomeType> &operator=(const ConcurrentBSTree<SomeType> &) = delete;
+    ~ConcurrentBSTree();
+    void InsertItem(const SomeType &item);
+    SomeType DeleteItem(const SomeType &item);
+    void MakeEmpty();
+    int Size() const;
+    bool IsFull() const;
+    bool IsEmpty() const;
+    SomeType Min() const;
+    SomeType Max() const;
+    int TotalLevels() const;
+    int Level(const SomeType &item) const;
+    bool Find(const SomeType &item, SomeType *retVal) const;
+    template<typename Visit>
+    void ForEach(Visit visit) const;
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// Publish()
+// Makes newRoot the current version, then retires the nodes only the old version used
+// Caller must hold writeLock
+template<typename SomeType>
+void ConcurrentBSTree<SomeType>::Publish(const Node *newRoot) {
+    const Node *oldRoot = this->rootPtr.load(memory_order_relaxed);
+
+    this->rootPtr.store(newRoot, memory_order_release);
+    Versions::Release(oldRoot);
+    EpochReclaim::Collect();
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// ConcurrentBSTree()
+// Default constructor initializes root pointer to NULL
+template<typename SomeType>
+ConcurrentBSTree<SomeType>::ConcurrentBSTree() {
+    this->rootPtr.store(nullptr);
+}
+
+// ~ConcurrentBSTree()
+// Destructor retires all tree nodes; no reader may be using the tree any more
+template<typename SomeType>
+ConcurrentBSTree<SomeType>::~ConcurrentBSTree() {
+    Versions::Release(this->rootPtr.load());
+    EpochReclaim::Collect();
+}
+
+// InsertItem()
+// Inserts item into the tree; concurrent readers see either the old or the new version
+// If item is already in the tree, throw FoundInBSTree exception
+template<typename SomeType>
+void ConcurrentBSTree<SomeType>::InsertItem(const SomeType &item) {
+    lock_guard<mutex> guard(this->writeLock);
+
+    Publish(Versions::Insert(this->rootPtr.load(memory_order_relaxed), item));
+}
+
+// DeleteItem()
+// Deletes item from the tree if item is present AND returns object
+// If tree is empty, throw the EmptyBSTree exception
+// If tree is not empty and item is NOT present, throw NotFoundBSTree
+template<typename SomeType>
+SomeType ConcurrentBSTree<SomeType>::DeleteItem(const SomeType &item) {
+    lock_guard<mutex> guard(this->writeLock);
+    const Node *root = this->rootPtr.load(memory_order_relaxed);
+
+    if (root == nullptr)
+        throw EmptyBSTree();
+
+    Publish(Versions::Delete(root, item));
+
+    return item;
+}
+
+// MakeEmpty()
+// Publishes an empty tree and retires every node
+template<typename SomeType>
+void ConcurrentBSTree<SomeType>::MakeEmpty() {
+    lock_guard<mutex> guard(this->writeLock);
+
+    Publish(nullptr);
+}
+
+// Size()
+// Returns total number of data values stored in the current version
+template<typename SomeType>
+int ConcurrentBSTree<SomeType>::Size() const {
+    EpochReclaim::ReadGuard guard;
+
+    return Versions::Count(this->rootPtr.load(memory_order_acquire));
+}
+
+// IsFull()
+// Returns true if tree is full; returns false otherwise
+template<typename SomeType>
+bool ConcurrentBSTree<SomeType>::IsFull() const {
+    return false;
+}
+
+// IsEmpty()
+// Returns true if tree is empty; returns false otherwise
+template<typename SomeType>
+bool ConcurrentBSTree<SomeType>::IsEmpty() const {
+    return this->rootPtr.load(memory_order_acquire) == nullptr;
+}
+
+// Min()
+// Returns minimum value in tree; throws EmptyBSTree if tree is empty
+template<typename SomeType>
+SomeType ConcurrentBSTree<SomeType>::Min() const {
+    EpochReclaim::ReadGuard guard;
+    const Node *tmp = this->rootPtr.load(memory_order_acquire);
+
+    if (tmp == nullptr)
+        throw EmptyBSTree();
+
+    while (tmp->leftPtr != nullptr)
+        tmp = tmp->leftPtr;
+
+    return tmp->data;
+}
+
+// Max()
+// Returns maximum value in tree; throws EmptyBSTree if tree is empty
+template<typename SomeType>
+SomeType ConcurrentBSTree<SomeType>::Max() const {
+    EpochReclaim::ReadGuard guard;
+    const Node *tmp = this->rootPtr.load(memory_order_acquire);
+
+    if (tmp == nullptr)
+        throw EmptyBSTree();
+
+    while (tmp->rightPtr != nullptr)
+        tmp = tmp->rightPtr;
+
+    return tmp->data;
+}
+
+// TotalLevels()
+// Returns the maximum level value for current tree contents
+// Throws EmptyBSTree if empty
+template<typename SomeType>
+int ConcurrentBSTree<SomeType>::TotalLevels() const {
+    EpochReclaim::ReadGuard guard;
+    const Node *root = this->rootPtr.load(memory_order_acquire);
+
+    if (root == nullptr)
+        throw EmptyBSTree();
+
+    return Versions::Height(root);
+}
+
+// Level()
+// Returns the level within the tree at which the value item is found
+// If tree is empty, throws EmptyBSTree
+// If tree is not empty and item is not found, throws NotFoundBSTree
+template<typename SomeType>
+int ConcurrentBSTree<SomeType>::Level(const SomeType &item) const {
+    EpochReclaim::ReadGuard guard;
+    const Node *tmp = this->rootPtr.load(memory_order_acquire);
+    int level = 0;
+
+    if (tmp == nullptr)
+        throw EmptyBSTree();
+
+    while (tmp != nullptr) {
+        if (item < tmp->data)
+            tmp = tmp->leftPtr;
+        else if (item > tmp->data)
+            tmp = tmp->rightPtr;
+        else
+            return level;
+        level++;
+    }
+
+    throw NotFoundBSTree();
+}
+
+// Find()
+// Copies the stored value equal to item into *retVal and returns true, or returns false if
+// item is not in the tree
+template<typename SomeType>
+bool ConcurrentBSTree<SomeType>::Find(const SomeType &item, SomeType *retVal) const {
+    EpochReclaim::ReadGuard guard;
+    const Node *tmp = this->rootPtr.load(memory_order_acquire);
+
+    while (tmp != nullptr) {
+        if (item < tmp->data) {
+            tmp = tmp->leftPtr;
+        } else if (item > tmp->data) {
+            tmp = tmp->rightPtr;
+        } else {
+            *retVal = tmp->data;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// ForEach()
+// Calls visit(value) in ascending order for every value of the version current at the call
+// Values are passed by const reference and must not be kept after visit returns
+template<typename SomeType>
+template<typename Visit>
+void ConcurrentBSTree<SomeType>::ForEach(Visit visit) const {
+    EpochReclaim::ReadGuard guard;
+
+    Versions::InOrderVisit(this->rootPtr.load(memory_order_acquire), visit);
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
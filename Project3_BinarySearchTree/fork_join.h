@@ -0,0 +1,179 @@
+//
+// fork_join.h  Small fork-join thread pool
+//
+// NOTES:
+// Invoke(left, right) offers right to the pool, runs left on the calling thread and then waits
+// for right.  While waiting, the caller runs other queued tasks instead of blocking, so nested
+// Invoke calls from recursive divide-and-conquer code cannot deadlock the pool.  A pool created
+// with one thread has no workers and runs everything on the caller.
+//
+
+#ifndef FORK_JOIN_H
+#define FORK_JOIN_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class ForkJoinPool {                   // Thread pool for fork-join parallelism
+private:
+    struct Task {                        // Work offered to the pool by Invoke
+        function<void()> run;
+        atomic<bool> done;
+        exception_ptr error;
+    };
+
+    mutex lock;                          // Guards tasks and stopping
+    condition_variable wake;             // Signals workers that tasks arrived or the pool is stopping
+    deque<Task *> tasks;                 // Tasks not yet started
+    vector<thread> workers;              // Worker threads (threads - 1 of them)
+    bool stopping;                       // Set by the destructor to end WorkerLoop
+
+    static void Run(Task *task);
+    bool RunOne();
+    void WorkerLoop();
+
+public:
+    explicit ForkJoinPool(int threads = static_cast<int>(thread::hardware_concurrency()));
+    ForkJoinPool(const ForkJoinPool &) = delete;
+    ForkJoinPool &operator=(const ForkJoinPool &) = delete;
+    ~ForkJoinPool();
+    int Threads() const;
+    template<typename Left, typename Right>
+    void Invoke(Left &&left, Right &&right);
+    static ForkJoinPool &Default();
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// Run()
+// Runs task, records any exception it throws and marks it done
+inline void ForkJoinPool::Run(Task *task) {
+    try {
+        task->run();
+    } catch (...) {
+        task->error = current_exception();
+    }
+    task->done.store(true, memory_order_release);
+}
+
+// RunOne()
+// Runs the oldest queued task on the calling thread; returns false if nothing was queued
+inline bool ForkJoinPool::RunOne() {
+    Task *task;
+    {
+        lock_guard<mutex> guard(this->lock);
+        if (this->tasks.empty())
+            return false;
+        task = this->tasks.front();
+        this->tasks.pop_front();
+    }
+
+    Run(task);
+    return true;
+}
+
+// WorkerLoop()
+// Body of each worker thread: sleep until tasks arrive, run them, exit when stopping
+inline void ForkJoinPool::WorkerLoop() {
+    while (true) {
+        Task *task;
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->wake.wait(guard, [this] { return this->stopping || !this->tasks.empty(); });
+            if (this->tasks.empty())
+                return;
+            task = this->tasks.front();
+            this->tasks.pop_front();
+        }
+
+        Run(task);
+    }
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// ForkJoinPool()
+// Starts threads - 1 workers; the thread calling Invoke is the remaining one
+inline ForkJoinPool::ForkJoinPool(int threads) {
+    this->stopping = false;
+
+    for (int i = 1; i < threads; ++i)
+        this->workers.emplace_back([this] { WorkerLoop(); });
+}
+
+// ~ForkJoinPool()
+// Stops and joins every worker; no Invoke may be in progress
+inline ForkJoinPool::~ForkJoinPool() {
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+
+    for (thread &worker : this->workers)
+        worker.join();
+}
+
+// Threads()
+// Returns the number of threads that can run tasks, counting the caller
+inline int ForkJoinPool::Threads() const {
+    return static_cast<int>(this->workers.size()) + 1;
+}
+
+// Invoke()
+// Runs left and right, possibly in parallel, and returns once both have finished
+// If either throws, the exception is rethrown here after both have finished
+template<typename Left, typename Right>
+void ForkJoinPool::Invoke(Left &&left, Right &&right) {
+    if (this->workers.empty()) {
+        left();
+        right();
+        return;
+    }
+
+    Task task{right, {false}, nullptr};
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->tasks.push_back(&task);
+    }
+    this->wake.notify_one();
+
+    exception_ptr leftError;
+    try {
+        left();
+    } catch (...) {
+        leftError = current_exception();
+    }
+
+    while (!task.done.load(memory_order_acquire)) {
+        if (!RunOne())
+            this_thread::yield();
+    }
+
+    if (leftError)
+        rethrow_exception(leftError);
+    if (task.error)
+        rethrow_exception(task.error);
+}
+
+// Default()
+// Returns a process-wide pool with one thread per hardware thread
+inline ForkJoinPool &ForkJoinPool::Default() {
+    static ForkJoinPool pool;
+    return pool;
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
@@ -0,0 +1,126 @@
+//
+// frozen_bstree.h  Read-only search tree in Eytzinger (BFS) order
+//
+// NOTES:
+// Values are kept in one contiguous array laid out like a complete binary heap: the children of
+// slot k live at 2k and 2k+1 (slot 0 is unused).  A descent touches one array slot per level,
+// the top levels stay hot in cache, and the loop has no data-dependent branch.  The grandchildren
+// a few levels down share cache lines, so each step prefetches them before the compare.
+//
+
+#ifndef FROZEN_BSTREE_H
+#define FROZEN_BSTREE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template<typename SomeType>
+class FrozenBSTree {                   // Immutable, cache-friendly search tree
+private:
+    vector<SomeType> slots;              // Eytzinger ordered values, slots[0] unused
+    size_t count;                        // Number of values stored
+
+    // Distance (in slots) from k to the first descendant prefetched on each step
+    static constexpr size_t PrefetchStride = sizeof(SomeType) >= 32 ? 2
+                                           : sizeof(SomeType) >= 16 ? 4
+                                           : sizeof(SomeType) >= 8  ? 8 : 16;
+
+    void Build(vector<size_t> &order, size_t &next, size_t k);
+
+public:
+    FrozenBSTree();
+    explicit FrozenBSTree(vector<SomeType> sorted);
+    const SomeType *Find(const SomeType &item) const;
+    int Size() const;
+    bool IsEmpty() const;
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// Build()
+// Recursive in-order walk of the implicit tree that records which sorted value each slot takes
+template<typename SomeType>
+void FrozenBSTree<SomeType>::Build(vector<size_t> &order, size_t &next, size_t k) {
+    if (k <= count) {
+        Build(order, next, 2 * k);
+        order[k] = next++;
+        Build(order, next, 2 * k + 1);
+    }
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// FrozenBSTree()
+// Default constructor creates an empty frozen tree
+template<typename SomeType>
+FrozenBSTree<SomeType>::FrozenBSTree() {
+    this->count = 0;
+}
+
+// FrozenBSTree()
+// Builds the frozen tree from values that are already in ascending order with no duplicates
+template<typename SomeType>
+FrozenBSTree<SomeType>::FrozenBSTree(vector<SomeType> sorted) {
+    size_t next = 0;
+
+    this->count = sorted.size();
+    vector<size_t> order(this->count + 1);
+    Build(order, next, 1);
+
+    // Values are appended in slot order, so SomeType need not be default-constructible; the
+    // unused slot 0 holds a copy of the root
+    this->slots.reserve(this->count + 1);
+    if (this->count > 0) {
+        this->slots.push_back(sorted[order[1]]);
+        for (size_t k = 1; k <= this->count; k++)
+            this->slots.push_back(std::move(sorted[order[k]]));
+    }
+}
+
+// Find()
+// Returns a pointer to the stored value equal to item, or nullptr if item is not present
+template<typename SomeType>
+const SomeType *FrozenBSTree<SomeType>::Find(const SomeType &item) const {
+    const SomeType *base = this->slots.data();
+    size_t k = 1;
+
+    while (k <= this->count) {
+        // Prefetch a few levels ahead, but only while that slot is still inside the array
+        size_t ahead = k * PrefetchStride;
+        if (ahead <= this->count)
+            __builtin_prefetch(base + ahead);
+        k = 2 * k + (base[k] < item);
+    }
+
+    // k went right on every compare since the last left turn; undo those steps and the left turn
+    k >>= __builtin_ffsll(~k);
+
+    if (k == 0 || item < base[k])
+        return nullptr;
+
+    return base + k;
+}
+
+// Size()
+// Returns total number of data values stored in the frozen tree
+template<typename SomeType>
+int FrozenBSTree<SomeType>::Size() const {
+    return static_cast<int>(this->count);
+}
+
+// IsEmpty()
+// Returns true if the frozen tree holds no values; returns false otherwise
+template<typename SomeType>
+bool FrozenBSTree<SomeType>::IsEmpty() const {
+    return this->count == 0;
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
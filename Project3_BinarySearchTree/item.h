@@ -22,10 +22,15 @@ public:
     Item();
     Item(int id, string name, float price);
     Item(const Item &otherItem);
+    Item(Item &&otherItem) noexcept;
     friend bool operator==(const Item &leftop, const Item &rightop);
     friend bool operator<(const Item &leftop, const Item &rightop);
     friend bool operator>(const Item &leftop, const Item &rightop);
-    void operator=(const Item &op);
+    Item &operator=(const Item &op);
+    Item &operator=(Item &&op) noexcept;
+    int GetID() const;
+    const string &GetName() const;
+    float GetPrice() const;
 
     // Overloaded >> operator
     // This allows all data associated with a Item object to be input simultaneously from an input stream
@@ -74,6 +79,13 @@ Item::Item(const Item &otherItem) {
     this->itemPrice = otherItem.itemPrice;
 }
 
+// Move constructor -- takes over the attributes of otherItem; its name is left empty
+Item::Item(Item &&otherItem) noexcept {
+    this->itemID = otherItem.itemID;
+    this->itemName = std::move(otherItem.itemName);
+    this->itemPrice = otherItem.itemPrice;
+}
+
 // Overloaded SAME AS operator
 // Returns true if leftop.itemID == rightop.itemID.  Returns false otherwise
 bool operator==(const Item &leftop, const Item &rightop) {
@@ -94,10 +106,37 @@ bool operator>(const Item &leftop, const Item &rightop) {
 
 // Overloaded ASSIGNMENT operator
 // Sets this->itemID = op.itemID,	this->itemName = op.itemName, this->itemPrice = op.itemPrice
-void Item::operator=(const Item &op) {
+Item &Item::operator=(const Item &op) {
     this->itemID = op.itemID;
     this->itemName = op.itemName;
     this->itemPrice = op.itemPrice;
+
+    return *this;
+}
+
+// Overloaded MOVE ASSIGNMENT operator
+// Same as above, but takes over op.itemName instead of copying it
+Item &Item::operator=(Item &&op) noexcept {
+    this->itemID = op.itemID;
+    this->itemName = std::move(op.itemName);
+    this->itemPrice = op.itemPrice;
+
+    return *this;
+}
+
+// Returns the item ID number (search key)
+int Item::GetID() const {
+    return this->itemID;
+}
+
+// Returns the item name
+const string &Item::GetName() const {
+    return this->itemName;
+}
+
+// Returns the item price
+float Item::GetPrice() const {
+    return this->itemPrice;
 }
 
 #endif
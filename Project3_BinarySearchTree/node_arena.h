@@ -0,0 +1,136 @@
+//
+// node_arena.h  Block allocator for fixed-size tree nodes
+//
+// NOTES:
+// Storage is carved out of large blocks by bumping an index, so nodes allocated one after another
+// sit next to each other in memory.  Released nodes go on an intrusive free list and are reused
+// before the bump pointer advances.  Clear() returns every block to the heap at once; it does not
+// run destructors, so the owner must destroy any live objects first.
+// Only BSTree allocates from a NodeArena, so its allocation counters are reported as BSTree's.
+//
+
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "../Common/instrumentation.h"
+
+using namespace std;
+
+// Snapshot of an arena's usage
+struct ArenaStats {
+    size_t blocks;                       // Number of blocks obtained from the heap
+    size_t capacity;                     // Total node slots in all blocks
+    size_t liveNodes;                    // Slots currently holding a node
+    size_t freeNodes;                    // Released slots waiting on the free list
+    double fragmentation;                // freeNodes / (liveNodes + freeNodes); 0 when nothing was handed out
+};
+
+template<typename NodeType>
+class NodeArena {                      // Per-container node allocator
+private:
+    union Slot {                         // Storage for one node, or a free list link once released
+        Slot *nextFree;
+        alignas(NodeType) unsigned char storage[sizeof(NodeType)];
+    };
+
+    static constexpr size_t BlockNodes = sizeof(Slot) >= 1024 ? 64 : 65536 / sizeof(Slot);
+
+    vector<Slot *> blocks;               // Every block obtained from the heap
+    size_t used;                         // Slots handed out from the newest block
+    Slot *freeList;                      // Most recently released slot
+    size_t liveNodes;                    // Slots currently holding a node
+    size_t freeNodes;                    // Slots on the free list
+
+public:
+    NodeArena();
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+    ~NodeArena();
+    void *Allocate();
+    void Release(NodeType *node);
+    void Clear();
+    ArenaStats Stats() const;
+};
+
+// NodeArena()
+// Creates an arena with no blocks; the first Allocate() obtains one
+template<typename NodeType>
+NodeArena<NodeType>::NodeArena() {
+    this->used = BlockNodes;
+    this->freeList = nullptr;
+    this->liveNodes = 0;
+    this->freeNodes = 0;
+}
+
+// ~NodeArena()
+// Returns every block to the heap
+template<typename NodeType>
+NodeArena<NodeType>::~NodeArena() {
+    Clear();
+}
+
+// Allocate()
+// Returns uninitialized storage for one node, reusing a released slot when one is available
+template<typename NodeType>
+void *NodeArena<NodeType>::Allocate() {
+    Slot *slot;
+
+    if (this->freeList != nullptr) {
+        slot = this->freeList;
+        this->freeList = slot->nextFree;
+        this->freeNodes--;
+    } else {
+        if (this->used == BlockNodes) {
+            this->blocks.push_back(static_cast<Slot *>(::operator new(BlockNodes * sizeof(Slot))));
+            this->used = 0;
+        }
+        slot = this->blocks.back() + this->used++;
+    }
+
+    this->liveNodes++;
+    INSTRUMENT_ALLOC(BSTree, 1, sizeof(NodeType));
+    return slot->storage;
+}
+
+// Release()
+// Puts the storage of an already destroyed node on the free list
+template<typename NodeType>
+void NodeArena<NodeType>::Release(NodeType *node) {
+    Slot *slot = reinterpret_cast<Slot *>(node);
+
+    slot->nextFree = this->freeList;
+    this->freeList = slot;
+    this->liveNodes--;
+    this->freeNodes++;
+    INSTRUMENT_FREE(BSTree, 1, sizeof(NodeType));
+}
+
+// Clear()
+// Returns every block to the heap in O(blocks); nodes still in the arena are not destroyed
+template<typename NodeType>
+void NodeArena<NodeType>::Clear() {
+    INSTRUMENT_FREE(BSTree, this->liveNodes, this->liveNodes * sizeof(NodeType));
+    for (Slot *block : this->blocks)
+        ::operator delete(block);
+
+    this->blocks.clear();
+    this->used = BlockNodes;
+    this->freeList = nullptr;
+    this->liveNodes = 0;
+    this->freeNodes = 0;
+}
+
+// Stats()
+// Returns block count, capacity, live and free node counts and the free-list fragmentation
+template<typename NodeType>
+ArenaStats NodeArena<NodeType>::Stats() const {
+    size_t handedOut = this->liveNodes + this->freeNodes;
+
+    return {this->blocks.size(), this->blocks.size() * BlockNodes, this->liveNodes, this->freeNodes,
+            handedOut == 0 ? 0.0 : static_cast<double>(this->freeNodes) / handedOut};
+}
+
+#endif
@@ -0,0 +1,424 @@
+//
+// persistent_bstree.h  Persistent (copy-on-write) AVL Binary Search Tree
+//
+// NOTES:
+// Nodes are immutable once built and are shared between trees through an atomic reference count,
+// so copying a PersistentBSTree is O(1): the copy just takes another reference to the root.
+// InsertItem and DeleteItem rebuild only the O(log n) path from the root to the change and reuse
+// every untouched subtree, so older copies keep seeing exactly the contents they were taken from.
+// Copies may be read on other threads while the original keeps changing.
+//
+// Private helpers take ownership of the node references passed to them and return an owned
+// reference; Retain() is used wherever a shared subtree is handed to a new parent.
+// When the last reference to a node is dropped its memory is handed to the Reclaim policy:
+// DeleteReclaim frees it at once, while ConcurrentBSTree defers it until no reader can see it.
+//
+
+#ifndef PERSISTENT_BSTREE_H
+#define PERSISTENT_BSTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include "bstree.h"
+
+using namespace std;
+
+template<typename SomeType>
+struct PersistentBSTreeNode {            // Shared, immutable node of PersistentBSTree
+    SomeType data;                               // Data stored in node
+    const PersistentBSTreeNode<SomeType> *leftPtr;   // Pointer to left subtree
+    const PersistentBSTreeNode<SomeType> *rightPtr;  // Pointer to right subtree
+    int height;                                  // Number of levels in subtree rooted at this node
+    int size;                                    // Number of nodes in subtree rooted at this node
+    mutable atomic<int> refCount;                // Number of trees and parent nodes sharing this node
+};
+
+// Reclaim policy that deletes an unreferenced node immediately
+struct DeleteReclaim {
+    template<typename NodeType>
+    static void Retire(const NodeType *node) { delete node; }
+};
+
+template<typename SomeType>
+class ConcurrentBSTree;
+
+template<typename SomeType, typename Reclaim = DeleteReclaim>
+class PersistentBSTree {               // Persistent BSTree Abstract Data Type
+private:
+    friend class ConcurrentBSTree<SomeType>;
+
+    typedef PersistentBSTreeNode<SomeType> Node;
+
+    const Node *rootPtr;                 // Pointer to root of this version of the tree
+    static int Height(const Node *treePtr);
+    static int Count(const Node *treePtr);
+    static const Node *Retain(const Node *treePtr);
+    static void Release(const Node *treePtr);
+    static const Node *MakeNode(const SomeType &data, const Node *left, const Node *right);
+    static const Node *Balance(const SomeType &data, const Node *left, const Node *right);
+    static const Node *Insert(const Node *treePtr, const SomeType &item);
+    static const Node *Delete(const Node *treePtr, const SomeType &item);
+    static const Node *DeleteMax(const Node *treePtr, const Node *&maxNode);
+    template<typename Visit>
+    static void InOrderVisit(const Node *treePtr, Visit &visit);
+
+public:
+    PersistentBSTree();
+    PersistentBSTree(const PersistentBSTree<SomeType, Reclaim> &someTree);
+    PersistentBSTree<SomeType, Reclaim> &operator=(const PersistentBSTree<SomeType, Reclaim> &originalTree);
+    ~PersistentBSTree();
+    void InsertItem(const SomeType &item);
+    SomeType DeleteItem(const SomeType &item);
+    void MakeEmpty();
+    int Size() const;
+    bool IsFull() const;
+    bool IsEmpty() const;
+    SomeType Min() const;
+    SomeType Max() const;
+    int TotalLevels() const;
+    int Level(const SomeType &item) const;
+    const SomeType *Find(const SomeType &item) const;
+    template<typename Visit>
+    void ForEach(Visit visit) const;
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// Height()
+// Returns the number of levels in the subtree pointed to by treePtr (0 for an empty subtree)
+template<typename SomeType, typename Reclaim>
+int PersistentBSTree<SomeType, Reclaim>::Height(const Node *treePtr) {
+    return treePtr == nullptr ? 0 : treePtr->height;
+}
+
+// Count()
+// Returns the number of nodes in the subtree pointed to by treePtr (0 for an empty subtree)
+template<typename SomeType, typename Reclaim>
+int PersistentBSTree<SomeType, Reclaim>::Count(const Node *treePtr) {
+    return treePtr == nullptr ? 0 : treePtr->size;
+}
+
+// Retain()
+// Takes one more reference to treePtr and returns it
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::Retain(const Node *treePtr) {
+    if (treePtr != nullptr)
+        treePtr->refCount.fetch_add(1, memory_order_relaxed);
+    return treePtr;
+}
+
+// Release()
+// Drops one reference to treePtr; the last reference releases its children and retires the node
+template<typename SomeType, typename Reclaim>
+void PersistentBSTree<SomeType, Reclaim>::Release(const Node *treePtr) {
+    if (treePtr != nullptr && treePtr->refCount.fetch_sub(1, memory_order_acq_rel) == 1) {
+        Release(treePtr->leftPtr);
+        Release(treePtr->rightPtr);
+        Reclaim::Retire(treePtr);
+    }
+}
+
+// MakeNode()
+// Builds a new node over the (owned) subtrees left and right
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::MakeNode(const SomeType &data, const Node *left, const Node *right) {
+    return new Node{data, left, right, 1 + max(Height(left), Height(right)),
+                    1 + Count(left) + Count(right), {1}};
+}
+
+// Balance()
+// Builds a node over the (owned) subtrees left and right, whose heights differ by at most two,
+// applying the single or double AVL rotation needed to keep the result balanced
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::Balance(const SomeType &data, const Node *left, const Node *right) {
+    const Node *result;
+
+    if (Height(left) > Height(right) + 1) {
+        if (Height(left->leftPtr) >= Height(left->rightPtr)) {
+            result = MakeNode(left->data, Retain(left->leftPtr),
+                              MakeNode(data, Retain(left->rightPtr), right));
+        } else {
+            const Node *pivot = left->rightPtr;
+            result = MakeNode(pivot->data, MakeNode(left->data, Retain(left->leftPtr), Retain(pivot->leftPtr)),
+                              MakeNode(data, Retain(pivot->rightPtr), right));
+        }
+        Release(left);
+    } else if (Height(right) > Height(left) + 1) {
+        if (Height(right->rightPtr) >= Height(right->leftPtr)) {
+            result = MakeNode(right->data, MakeNode(data, left, Retain(right->leftPtr)),
+                              Retain(right->rightPtr));
+        } else {
+            const Node *pivot = right->leftPtr;
+            result = MakeNode(pivot->data, MakeNode(data, left, Retain(pivot->leftPtr)),
+                              MakeNode(right->data, Retain(pivot->rightPtr), Retain(right->rightPtr)));
+        }
+        Release(right);
+    } else {
+        result = MakeNode(data, left, right);
+    }
+
+    return result;
+}
+
+// Insert()
+// Returns a new version of the subtree pointed to by treePtr with item added
+// Throws FoundInBSTree, before anything is allocated, if item is already in the subtree
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::Insert(const Node *treePtr, const SomeType &item) {
+    if (treePtr == nullptr)
+        return MakeNode(item, nullptr, nullptr);
+
+    if (item < treePtr->data) {
+        const Node *left = Insert(treePtr->leftPtr, item);
+        return Balance(treePtr->data, left, Retain(treePtr->rightPtr));
+    } else if (item > treePtr->data) {
+        const Node *right = Insert(treePtr->rightPtr, item);
+        return Balance(treePtr->data, Retain(treePtr->leftPtr), right);
+    } else {
+        // Item to insert must be equal to the current item
+        throw FoundInBSTree();
+    }
+}
+
+// Delete()
+// Returns a new version of the subtree pointed to by treePtr with item removed
+// Throws NotFoundBSTree, before anything is allocated, if item is not in the subtree
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::Delete(const Node *treePtr, const SomeType &item) {
+    if (treePtr == nullptr)
+        throw NotFoundBSTree();
+
+    if (item < treePtr->data) {
+        const Node *left = Delete(treePtr->leftPtr, item);
+        return Balance(treePtr->data, left, Retain(treePtr->rightPtr));
+    } else if (item > treePtr->data) {
+        const Node *right = Delete(treePtr->rightPtr, item);
+        return Balance(treePtr->data, Retain(treePtr->leftPtr), right);
+    } else if (treePtr->leftPtr == nullptr) {
+        return Retain(treePtr->rightPtr);
+    } else if (treePtr->rightPtr == nullptr) {
+        return Retain(treePtr->leftPtr);
+    } else {
+        // Two children: the predecessor takes the place of the deleted value
+        // The old version still holds the predecessor's node, so its value can be copied from there
+        const Node *predecessor;
+        const Node *left = DeleteMax(treePtr->leftPtr, predecessor);
+        return Balance(predecessor->data, left, Retain(treePtr->rightPtr));
+    }
+}
+
+// DeleteMax()
+// Returns a new version of the non-empty subtree pointed to by treePtr without its largest value,
+// whose node is stored in maxNode
+template<typename SomeType, typename Reclaim>
+const PersistentBSTreeNode<SomeType> *PersistentBSTree<SomeType, Reclaim>::DeleteMax(const Node *treePtr, const Node *&maxNode) {
+    if (treePtr->rightPtr == nullptr) {
+        maxNode = treePtr;
+        return Retain(treePtr->leftPtr);
+    }
+
+    const Node *right = DeleteMax(treePtr->rightPtr, maxNode);
+    return Balance(treePtr->data, Retain(treePtr->leftPtr), right);
+}
+
+// InOrderVisit()
+// Calls visit on each value of the subtree pointed to by treePtr in inorder
+template<typename SomeType, typename Reclaim>
+template<typename Visit>
+void PersistentBSTree<SomeType, Reclaim>::InOrderVisit(const Node *treePtr, Visit &visit) {
+    if (treePtr != nullptr) {
+        InOrderVisit(treePtr->leftPtr, visit);
+        visit(treePtr->data);
+        InOrderVisit(treePtr->rightPtr, visit);
+    }
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// PersistentBSTree()
+// Default constructor initializes root pointer to NULL
+template<typename SomeType, typename Reclaim>
+PersistentBSTree<SomeType, Reclaim>::PersistentBSTree() {
+    this->rootPtr = nullptr;
+}
+
+// PersistentBSTree()
+// Copy constructor shares the nodes of someTree in O(1)
+template<typename SomeType, typename Reclaim>
+PersistentBSTree<SomeType, Reclaim>::PersistentBSTree(const PersistentBSTree<SomeType, Reclaim> &someTree) {
+    this->rootPtr = Retain(someTree.rootPtr);
+}
+
+// operator=()
+// Overloaded assignment operator shares the nodes of originalTree in O(1)
+template<typename SomeType, typename Reclaim>
+PersistentBSTree<SomeType, Reclaim> &PersistentBSTree<SomeType, Reclaim>::operator=(const PersistentBSTree<SomeType, Reclaim> &originalTree) {
+    const Node *oldRoot = this->rootPtr;
+
+    this->rootPtr = Retain(originalTree.rootPtr);
+    Release(oldRoot);
+
+    return *this;
+}
+
+// ~PersistentBSTree()
+// Destructor releases this version's reference; nodes still shared with other versions survive
+template<typename SomeType, typename Reclaim>
+PersistentBSTree<SomeType, Reclaim>::~PersistentBSTree() {
+    Release(this->rootPtr);
+}
+
+// InsertItem()
+// Inserts item into this version of the tree, copying only the nodes on the path to item
+// If item is already in the tree, throw FoundInBSTree exception
+template<typename SomeType, typename Reclaim>
+void PersistentBSTree<SomeType, Reclaim>::InsertItem(const SomeType &item) {
+    const Node *newRoot = Insert(this->rootPtr, item);
+
+    Release(this->rootPtr);
+    this->rootPtr = newRoot;
+}
+
+// DeleteItem()
+// Deletes item from this version of the tree if item is present AND returns object
+// If tree is empty, throw the EmptyBSTree exception
+// If tree is not empty and item is NOT present, throw NotFoundBSTree
+template<typename SomeType, typename Reclaim>
+SomeType PersistentBSTree<SomeType, Reclaim>::DeleteItem(const SomeType &item) {
+    if (this->IsEmpty())
+        throw EmptyBSTree();
+
+    const Node *newRoot = Delete(this->rootPtr, item);
+
+    Release(this->rootPtr);
+    this->rootPtr = newRoot;
+
+    return item;
+}
+
+// MakeEmpty()
+// Releases this version's nodes and sets root pointer to NULL
+template<typename SomeType, typename Reclaim>
+void PersistentBSTree<SomeType, Reclaim>::MakeEmpty() {
+    Release(this->rootPtr);
+    this->rootPtr = nullptr;
+}
+
+// Size()
+// Returns total number of data values stored in tree
+template<typename SomeType, typename Reclaim>
+int PersistentBSTree<SomeType, Reclaim>::Size() const {
+    return Count(this->rootPtr);
+}
+
+// IsFull()
+// Returns true if tree is full; returns false otherwise
+template<typename SomeType, typename Reclaim>
+bool PersistentBSTree<SomeType, Reclaim>::IsFull() const {
+    return false;
+}
+
+// IsEmpty()
+// Returns true if tree is empty; returns false otherwise
+template<typename SomeType, typename Reclaim>
+bool PersistentBSTree<SomeType, Reclaim>::IsEmpty() const {
+    return this->rootPtr == nullptr;
+}
+
+// Min()
+// Returns minimum value in tree; throws EmptyBSTree if tree is empty
+template<typename SomeType, typename Reclaim>
+SomeType PersistentBSTree<SomeType, Reclaim>::Min() const {
+    if (this->IsEmpty())
+        throw EmptyBSTree();
+
+    const Node *tmp = this->rootPtr;
+    while (tmp->leftPtr != nullptr)
+        tmp = tmp->leftPtr;
+
+    return tmp->data;
+}
+
+// Max()
+// Returns maximum value in tree; throws EmptyBSTree if tree is empty
+template<typename SomeType, typename Reclaim>
+SomeType PersistentBSTree<SomeType, Reclaim>::Max() const {
+    if (this->IsEmpty())
+        throw EmptyBSTree();
+
+    const Node *tmp = this->rootPtr;
+    while (tmp->rightPtr != nullptr)
+        tmp = tmp->rightPtr;
+
+    return tmp->data;
+}
+
+// TotalLevels()
+// Returns the maximum level value for current tree contents
+// Throws EmptyBSTree if empty
+template<typename SomeType, typename Reclaim>
+int PersistentBSTree<SomeType, Reclaim>::TotalLevels() const {
+    if (this->IsEmpty())
+        throw EmptyBSTree();
+
+    return Height(this->rootPtr);
+}
+
+// Level()
+// Returns the level within the tree at which the value item is found
+// If tree is empty, throws EmptyBSTree
+// If tree is not empty and item is not found, throws NotFoundBSTree
+template<typename SomeType, typename Reclaim>
+int PersistentBSTree<SomeType, Reclaim>::Level(const SomeType &item) const {
+    if (this->IsEmpty())
+        throw EmptyBSTree();
+
+    const Node *tmp = this->rootPtr;
+    int level = 0;
+
+    while (tmp != nullptr) {
+        if (item < tmp->data)
+            tmp = tmp->leftPtr;
+        else if (item > tmp->data)
+            tmp = tmp->rightPtr;
+        else
+            return level;
+        level++;
+    }
+
+    throw NotFoundBSTree();
+}
+
+// Find()
+// Returns a pointer to the stored value equal to item, or nullptr if item is not in the tree
+// The pointer stays valid while any version sharing that node is alive
+template<typename SomeType, typename Reclaim>
+const SomeType *PersistentBSTree<SomeType, Reclaim>::Find(const SomeType &item) const {
+    const Node *tmp = this->rootPtr;
+
+    while (tmp != nullptr) {
+        if (item < tmp->data)
+            tmp = tmp->leftPtr;
+        else if (item > tmp->data)
+            tmp = tmp->rightPtr;
+        else
+            return &tmp->data;
+    }
+
+    return nullptr;
+}
+
+// ForEach()
+// Calls visit(value) for every value in ascending order; values are passed by const reference
+template<typename SomeType, typename Reclaim>
+template<typename Visit>
+void PersistentBSTree<SomeType, Reclaim>::ForEach(Visit visit) const {
+    InOrderVisit(this->rootPtr, visit);
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif
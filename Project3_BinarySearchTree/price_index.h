@@ -0,0 +1,202 @@
+//
+// price_index.h  Catalog of Items with a secondary index on price
+//
+// NOTES:
+// Item orders by ID only, so a price query on a BSTree<Item> has to visit every item.
+// PriceIndexedCatalog keeps the items in a BSTree<Item> and, next to it, a BSTree of
+// (price, id) keys.  InsertItem and DeleteItem update both trees, so a price range costs one
+// O(log n) descent in the index plus one lookup per item reported.  Items with equal prices
+// come out in ID order.  A NaN price has no place in that order, so InsertItem rejects it.
+//
+
+#ifndef PRICE_INDEX_H
+#define PRICE_INDEX_H
+
+#include "item.h"
+#include "bstree.h"
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+// Exception classes
+class InvalidPriceError: public std::exception { };   // Exception class models a NaN item price
+
+// Index entry: an item's price together with its ID, ordered by price and then by ID
+struct PriceKey {
+    float price;
+    int id;
+};
+
+// Overloaded LESS THAN operator
+// Returns true if leftop sorts before rightop by price, or by ID when prices are equal
+inline bool operator<(const PriceKey &leftop, const PriceKey &rightop) {
+    return leftop.price < rightop.price || (leftop.price == rightop.price && leftop.id < rightop.id);
+}
+
+// Overloaded GREATER THAN operator
+// Returns true if leftop sorts after rightop by price, or by ID when prices are equal
+inline bool operator>(const PriceKey &leftop, const PriceKey &rightop) {
+    return rightop < leftop;
+}
+
+class PriceIndexedCatalog {            // BSTree<Item> plus an ordered index on itemPrice
+private:
+    static constexpr size_t LookupBatch = 256;   // Index hits resolved per FindMany call
+
+    BSTree<Item, AVLBalance> items;      // Primary tree, ordered by ID
+    BSTree<PriceKey, AVLBalance> byPrice;   // One (price, id) key per item in items
+
+    template<typename Iterator, typename Visit>
+    void VisitKeys(Iterator first, Iterator last, size_t limit, Visit &visit) const;
+
+public:
+    void InsertItem(const Item &item);
+    Item DeleteItem(const Item &item);
+    void MakeEmpty();
+    int Size() const;
+    bool IsEmpty() const;
+    const Item *Find(const Item &item) const;
+    const BSTree<Item, AVLBalance> &Items() const;
+    template<typename Visit>
+    void PriceRange(float lo, float hi, Visit visit) const;
+    vector<Item> Cheapest(int k) const;
+    vector<Item> MostExpensive(int k) const;
+};
+
+/********  Start of Private Interface Functions  *********/
+
+// VisitKeys()
+// Calls visit(item) for the items named by the first limit keys in [first, last), in that order
+// Keys are looked up LookupBatch at a time through FindMany so the lookups overlap
+template<typename Iterator, typename Visit>
+void PriceIndexedCatalog::VisitKeys(Iterator first, Iterator last, size_t limit, Visit &visit) const {
+    vector<Item> keys;
+    vector<const Item *> found;
+
+    keys.reserve(LookupBatch);
+    while (first != last && limit > 0) {
+        keys.clear();
+        for (; first != last && limit > 0 && keys.size() < LookupBatch; ++first, --limit)
+            keys.emplace_back(first->id, "", 0.0f);
+
+        this->items.FindMany(keys, found);
+        for (const Item *item : found)
+            visit(*item);
+    }
+}
+
+/********  End of Private Interface Functions  *********/
+
+
+/********  Start of Public Interface Functions  *********/
+
+// InsertItem()
+// Inserts item into the catalog and its price into the index
+// If an item with the same ID is already present, throws FoundInBSTree and changes nothing
+// If item's price is NaN, throws InvalidPriceError and changes nothing
+inline void PriceIndexedCatalog::InsertItem(const Item &item) {
+    if (isnan(item.GetPrice()))
+        throw InvalidPriceError();
+
+    this->items.InsertItem(item);
+
+    try {
+        this->byPrice.InsertItem(PriceKey{item.GetPrice(), item.GetID()});
+    } catch (...) {
+        this->items.DeleteItem(item);
+        throw;
+    }
+}
+
+// DeleteItem()
+// Deletes the item with item's ID from the catalog and the index AND returns the stored item
+// If the catalog is empty, throw the EmptyBSTree exception
+// If it is not empty and no item has that ID, throw NotFoundBSTree
+inline Item PriceIndexedCatalog::DeleteItem(const Item &item) {
+    const Item *stored = this->items.Find(item);
+
+    if (stored == nullptr)
+        return this->items.DeleteItem(item);     // Throws EmptyBSTree or NotFoundBSTree
+
+    Item removed = *stored;
+    this->byPrice.DeleteItem(PriceKey{removed.GetPrice(), removed.GetID()});
+    this->items.DeleteItem(removed);
+
+    return removed;
+}
+
+// MakeEmpty()
+// Deletes every item from the catalog and the index
+inline void PriceIndexedCatalog::MakeEmpty() {
+    this->items.MakeEmpty();
+    this->byPrice.MakeEmpty();
+}
+
+// Size()
+// Returns the number of items in the catalog
+inline int PriceIndexedCatalog::Size() const {
+    return this->items.Size();
+}
+
+// IsEmpty()
+// Returns true if the catalog holds no items; returns false otherwise
+inline bool PriceIndexedCatalog::IsEmpty() const {
+    return this->items.IsEmpty();
+}
+
+// Find()
+// Returns a pointer to the stored item with item's ID, or nullptr if there is none
+inline const Item *PriceIndexedCatalog::Find(const Item &item) const {
+    return this->items.Find(item);
+}
+
+// Items()
+// Returns the primary tree for read-only queries by ID
+inline const BSTree<Item, AVLBalance> &PriceIndexedCatalog::Items() const {
+    return this->items;
+}
+
+// PriceRange()
+// Calls visit(item) for every item priced from lo to hi inclusive, cheapest first
+template<typename Visit>
+void PriceIndexedCatalog::PriceRange(float lo, float hi, Visit visit) const {
+    if (!(lo <= hi))
+        return;
+
+    auto first = this->byPrice.LowerBound(PriceKey{lo, INT_MIN});
+    auto last = this->byPrice.UpperBound(PriceKey{hi, INT_MAX});
+
+    VisitKeys(first, last, SIZE_MAX, visit);
+}
+
+// Cheapest()
+// Returns the k cheapest items (fewer if the catalog is smaller), cheapest first
+inline vector<Item> PriceIndexedCatalog::Cheapest(int k) const {
+    vector<Item> result;
+    auto collect = [&result](const Item &item) { result.push_back(item); };
+
+    VisitKeys(this->byPrice.begin(), this->byPrice.end(), k < 0 ? 0 : k, collect);
+
+    return result;
+}
+
+// MostExpensive()
+// Returns the k most expensive items (fewer if the catalog is smaller), most expensive first
+inline vector<Item> PriceIndexedCatalog::MostExpensive(int k) const {
+    vector<Item> result;
+    auto collect = [&result](const Item &item) { result.push_back(item); };
+    auto last = make_reverse_iterator(this->byPrice.begin());
+
+    VisitKeys(make_reverse_iterator(this->byPrice.end()), last, k < 0 ? 0 : k, collect);
+
+    return result;
+}
+
+/********  End of Public Interface Functions  *********/
+
+#endif